@@ -0,0 +1,37 @@
+#ifndef SXC_BENCH_H
+#define SXC_BENCH_H
+
+#include <stdio.h>
+#include <time.h>
+#include "sxc.h"
+
+
+/* Each benchmark runs its loop BENCH_ROUNDS times and reports the fastest
+    round, in nanoseconds per iteration. */
+#define BENCH_ROUNDS (5)
+
+
+/***** Macros *****/
+
+/* times iterations runs of STATEMENT (which may use the int i) and prints the
+    best round as NAME's ns per iteration */
+#define BENCH(NAME, ITERATIONS, STATEMENT) \
+  do { \
+    double best = -1; \
+    double elapsed; \
+    int round; \
+    int i; \
+    for (round = 0; round < BENCH_ROUNDS; round++) { \
+      clock_t start = clock(); \
+      for (i = 0; i < (ITERATIONS); i++) { \
+        STATEMENT; \
+      } \
+      elapsed = (double)(clock() - start); \
+      if (best < 0 || elapsed < best) { \
+        best = elapsed; \
+      } \
+    } \
+    printf("%-28s %8.1f ns\n", (NAME), best * 1e9 / CLOCKS_PER_SEC / (ITERATIONS)); \
+  } while (0)
+
+#endif
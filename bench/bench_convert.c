@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+
+
+/* Times sxc_value_get() for the conversions that go through its dispatch
+    table: identity conversions (scalars, arrays, and script values), numeric
+    conversions, script strings to numbers, and one that fails.  The only
+    binding function they call is the string binding's to_cchars().
+
+    "make baseline REV=<commit>" builds this against the sources at another
+    commit (e.g. the one before the dispatch table), for before and after
+    numbers. */
+
+
+#define CALL_COUNT (10000000)
+
+static SxcContextBinding CONTEXT_BINDING;
+static SxcMapBinding MAP_BINDING;
+
+/* NOTE the underlying value of a script string is its null terminated chars */
+static void string_to_cchars(void* underlying, SxcValue* return_value) {
+  sxc_value_set(return_value, sxc_cchars, (char*)underlying, (int)strlen((char*)underlying));
+}
+
+static SxcStringBinding STRING_BINDING = { string_to_cchars, 1 };
+
+/* NOTE results are summed into this so the loops can't be optimized away */
+static volatile int sink;
+
+
+static void run(SxcContext* context) {
+  int numbers[4] = {1, 2, 3, 4};
+  SxcValue value;
+  SxcMapBinding* map_binding;
+  void* underlying;
+  double cdouble;
+  char* cstring;
+  int* cints;
+  bool cbool;
+  int length;
+  int cint;
+
+  value.context = context;
+
+  sxc_value_set(&value, sxc_cint, 5);
+  BENCH("cint -> cint", CALL_COUNT, sink += sxc_value_get(&value, sxc_cint, &cint));
+  BENCH("cint -> cdouble", CALL_COUNT, sink += sxc_value_get(&value, sxc_cdouble, &cdouble));
+  BENCH("cint -> cbool", CALL_COUNT, sink += sxc_value_get(&value, sxc_cbool, &cbool));
+
+  sxc_value_set(&value, sxc_cdouble, 5.5);
+  BENCH("cdouble -> cint", CALL_COUNT, sink += sxc_value_get(&value, sxc_cint, &cint));
+  BENCH("cdouble -> smap (fails)", CALL_COUNT, sink += sxc_value_get(&value, sxc_smap, &underlying, &map_binding));
+
+  sxc_value_set(&value, sxc_sstring, "12345", &STRING_BINDING);
+  BENCH("sstring -> cint", CALL_COUNT, sink += sxc_value_get(&value, sxc_cint, &cint));
+  BENCH("sstring -> cdouble", CALL_COUNT, sink += sxc_value_get(&value, sxc_cdouble, &cdouble));
+
+  sxc_value_set(&value, sxc_cstring, "x");
+  BENCH("cstring -> cstring", CALL_COUNT, sink += sxc_value_get(&value, sxc_cstring, &cstring));
+
+  sxc_value_set(&value, sxc_cints, numbers, 4);
+  BENCH("cints -> cints", CALL_COUNT, sink += sxc_value_get(&value, sxc_cints, &cints, &length));
+
+  sxc_value_set(&value, sxc_smap, numbers, &MAP_BINDING);
+  BENCH("smap -> smap", CALL_COUNT, sink += sxc_value_get(&value, sxc_smap, &underlying, &map_binding));
+}
+
+
+int main(void) {
+  SxcContext context;
+
+  sxc_try(&context, NULL, &CONTEXT_BINDING, 0, run);
+  sxc_finally(&context);
+  return 0;
+}
@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+int sxc_number_todouble(const char* cchars, int length, double* cdouble);
+
+
+/* Compares sxc_number_todouble() against sscanf() (which it replaced) and
+    strtod(), on a mix of short ("%.6f") and round-trip ("%.17g") numbers, none
+    of them null terminated where the length matters. */
+
+
+#define NUMBER_COUNT (1000000)
+#define NUMBER_SIZE (32)
+
+static char numbers[NUMBER_COUNT][NUMBER_SIZE];
+static int lengths[NUMBER_COUNT];
+
+/* NOTE results are summed into this so the loops can't be optimized away */
+static volatile double sink;
+
+
+/* the old way of parsing a number that isn't null terminated */
+static int scan_double(const char* cchars, int length, double* cdouble) {
+  char format[16];
+
+  sprintf(format, "%%%dlf", length);
+  return sscanf(cchars, format, cdouble) == 1;
+}
+
+
+static int strtod_double(const char* cchars, int length, double* cdouble) {
+  char* end;
+
+  *cdouble = strtod(cchars, &end);
+  return end == cchars + length;
+}
+
+
+int main(void) {
+  double cdouble = 0;
+  int n;
+
+  srand(1);
+  for (n = 0; n < NUMBER_COUNT; n++) {
+    lengths[n] = sprintf(numbers[n], (n % 2) ? "%.6f" : "%.17g", (rand() / (double)RAND_MAX) * 1000.0);
+  }
+
+  BENCH("sscanf", NUMBER_COUNT, (scan_double(numbers[i], lengths[i], &cdouble), sink += cdouble));
+  BENCH("strtod", NUMBER_COUNT, (strtod_double(numbers[i], lengths[i], &cdouble), sink += cdouble));
+  BENCH("sxc_number_todouble", NUMBER_COUNT, (sxc_number_todouble(numbers[i], lengths[i], &cdouble), sink += cdouble));
+
+  /* check they agree, so a fast but wrong parser doesn't look good */
+  for (n = 0; n < NUMBER_COUNT; n++) {
+    double expected = strtod(numbers[n], NULL);
+
+    if (!sxc_number_todouble(numbers[n], lengths[n], &cdouble) || cdouble != expected) {
+      fprintf(stderr, "mismatch parsing \"%s\"\n", numbers[n]);
+      return 1;
+    }
+  }
+  return 0;
+}
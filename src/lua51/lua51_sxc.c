@@ -1,9 +1,83 @@
+#include <limits.h>
+#include <string.h>
 #include "lua51_sxc.h"
 
 
+static int l_state_gc(lua_State* L) {
+  sxc_state_close((SxcState*)lua_touserdata(L, 1));
+  return 0;
+}
+
+
+/* pushes the formatted message of error */
+static void push_error_string(lua_State* L, const SxcError* error) {
+  char* buffer;
+
+  buffer = (char*)lua_newuserdata(L, sxc_error_format(error, NULL) + 1);
+  lua_pushlstring(L, buffer, sxc_error_format(error, buffer));
+  lua_replace(L, -2);
+}
+
+
+/* formats the message of the error userdata at index (see push_error) */
+static void push_error_message(lua_State* L, int index) {
+  push_error_string(L, (SxcError*)lua_touserdata(L, index));
+}
+
+
+static int l_error_tostring(lua_State* L) {
+  luaL_checkudata(L, 1, ERROR_METATABLE_KEY);
+  push_error_message(L, 1);
+  return 1;
+}
+
+
+/* error.code and error.message */
+static int l_error_index(lua_State* L) {
+  SxcError* error = (SxcError*)luaL_checkudata(L, 1, ERROR_METATABLE_KEY);
+  const char* key = lua_tostring(L, 2);
+
+  if (key != NULL && strcmp(key, "code") == 0) {
+    lua_pushinteger(L, error->code);
+  } else if (key != NULL && strcmp(key, "message") == 0) {
+    push_error_message(L, 1);
+  } else {
+    lua_pushnil(L);
+  }
+  return 1;
+}
+
+
 int luaopen_lua51_sxc(lua_State *L) {
+  SxcState* state;
+  void* allocud;
+  lua_Alloc allocf;
+
 printf("in luaopen\n");
 
+  /* create SxcState, which uses this Lua state's allocator and is closed
+      along with it */
+  state = (SxcState*)lua_newuserdata(L, sizeof(SxcState));
+  allocf = lua_getallocf(L, &allocud);
+  sxc_state_init(state, allocf, allocud);
+  lua_newtable(L);
+    lua_pushcfunction(L, l_state_gc);
+    lua_setfield(L, -2, "__gc");
+  lua_setmetatable(L, -2);
+  lua_setfield(L, LUA_REGISTRYINDEX, STATE_KEY);
+
+  /* create metatable for errors raised by sxc_raise() */
+  luaL_newmetatable(L, ERROR_METATABLE_KEY);
+    lua_pushcfunction(L, l_error_tostring);
+    lua_setfield(L, -2, "__tostring");
+    lua_pushcfunction(L, l_error_index);
+    lua_setfield(L, -2, "__index");
+  lua_pop(L, 1);
+
+  /* create cache of small ints' strings (see int_to_sstring) */
+  lua_newtable(L);
+  lua_setfield(L, LUA_REGISTRYINDEX, INT_STRINGS_KEY);
+
   /* create table for map type ctors */
   lua_newtable(L);
     /* add list map type ctor placeholder (so 1st index isn't nil) */
@@ -21,16 +95,70 @@ printf("in luaopen\n");
 
 
 int l_libfunc_invoke(lua_State* L) {
-  return libfunc_invoke((SxcLibFunc*)lua_touserdata(L, lua_upvalueindex(1)), L, lua_gettop(L));
+  return libfunc_invoke((SxcLibFunc*)lua_touserdata(L, lua_upvalueindex(1)), L, lua_gettop(L), 0);
+}
+
+
+int l_libfunc_invoke_nothrow(lua_State* L) {
+  return libfunc_invoke((SxcLibFunc*)lua_touserdata(L, lua_upvalueindex(1)), L, lua_gettop(L), 1);
+}
+
+
+/* Pushes a copy of error as an "sxc_error" userdata, whose message is only
+    formatted if the script asks for it (via tostring() or error.message), so
+    scripts that pcall() and move on (e.g. after a type error) don't pay for it.
+    NOTE Lua 5.1 doesn't apply __tostring to error values, so hosts whose
+    scripts expect string errors (e.g. lua.c, or err:match()) can opt into them
+    per Lua state (see STRING_ERRORS_KEY).
+    NOTE the format is static, but string args live in the context's arena, so
+    they're copied in after the SxcError. */
+static void push_error(lua_State* L, const SxcError* error) {
+  SxcError* copy;
+  char* strings;
+  int size = sizeof(SxcError);
+  int i;
+
+  for (i = 0; i < error->argcount; i += 1) {
+    if (error->args[i].conversion == 's') {
+      size += strlen(error->args[i].value.s) + 1;
+    }
+  }
+
+  copy = (SxcError*)lua_newuserdata(L, size);
+  memcpy(copy, error, sizeof(SxcError));
+  strings = (char*)(copy + 1);
+  for (i = 0; i < error->argcount; i += 1) {
+    if (error->args[i].conversion == 's') {
+      copy->args[i].value.s = strcpy(strings, error->args[i].value.s);
+      strings += strlen(strings) + 1;
+    }
+  }
+
+  luaL_getmetatable(L, ERROR_METATABLE_KEY);
+  lua_setmetatable(L, -2);
 }
 
 
-int libfunc_invoke(SxcLibFunc* func, lua_State* L, const int argcount) {
+int libfunc_invoke(SxcLibFunc* func, lua_State* L, const int argcount, int is_nothrow) {
   SxcContext context;
   const int final_top = lua_gettop(L) + 1;
 
-  sxc_try(&context, L, &CONTEXT_BINDING, argcount, func);
-  push_value(&context.return_value);
+  if (is_nothrow) {
+    sxc_try_nothrow(&context, L, &CONTEXT_BINDING, argcount, func);
+  } else {
+    sxc_try(&context, L, &CONTEXT_BINDING, argcount, func);
+  }
+  if (context.has_error && context.error.code != SXC_ERROR_MESSAGE) {
+    lua_getfield(L, LUA_REGISTRYINDEX, STRING_ERRORS_KEY);
+    if (lua_toboolean(L, -1)) {
+      push_error_string(L, &context.error);
+    } else {
+      push_error(L, &context.error);
+    }
+    lua_remove(L, -2);
+  } else {
+    push_value(&context.return_value);
+  }
   if (final_top < lua_gettop(L)) {
     /* NOTE after this point no SxcStrings, SxcMaps, or SxcFuncs are valid,
       because their index into the stack may be one replaced/popped below */
@@ -67,8 +195,12 @@ void get_value(int index, SxcValue* return_value) {
 
     case LUA_TNUMBER:
       number = (double)lua_tonumber(L, index);
-      if (number == (double)(int)number) {
+      if (number >= INT_MIN && number <= INT_MAX && number == (double)(int)number) {
         sxc_value_set(return_value, sxc_cint, (int)number);
+      } else if (number >= -9223372036854775808.0 && number < 9223372036854775808.0
+          && number == (double)(SxcInt64)number) {
+        /* NOTE Lua 5.1 numbers are doubles, so only ints up to 2^53 are exact */
+        sxc_value_set(return_value, sxc_cint64, (SxcInt64)number);
       } else {
         sxc_value_set(return_value, sxc_cdouble, number);
       }
@@ -85,6 +217,14 @@ void get_value(int index, SxcValue* return_value) {
     case LUA_TFUNCTION:
       sxc_value_set(return_value, sxc_sfunc, INT2PTR(index), &FUNC_BINDING);
       return;
+
+    case LUA_TUSERDATA:
+      if (to_buffer(L, index) != NULL) {
+        sxc_value_set(return_value, sxc_smap, INT2PTR(index), &BUFFER_BINDING);
+      } else {
+        sxc_value_set(return_value, sxc_null);
+      }
+      return;
   }
 }
 
@@ -100,6 +240,7 @@ void pop_value(SxcValue* return_value) {
     case sxc_cbool:
     case sxc_cint:
     case sxc_cdouble:
+    case sxc_cint64:
       lua_pop((lua_State*)(return_value->context->underlying), 1);
       break;
 
@@ -133,6 +274,10 @@ printf("in push_value, type:%d\n", value->type);
       lua_pushnumber(L, (lua_Number)value->data.cdouble);
       return;
 
+    case sxc_cint64:
+      lua_pushnumber(L, (lua_Number)value->data.cint64);
+      return;
+
     case sxc_sstring:
       lua_pushvalue(L, PTR2INT(value->data.sstring.underlying));
       return;
@@ -3,6 +3,15 @@
 #include "../sxc.h"
 
 #define MAPTYPE_CTORS_KEY ("sxc_maptype_ctors")
+#define STATE_KEY ("sxc_state")
+#define ERROR_METATABLE_KEY ("sxc_error")
+#define BUFFER_METATABLE_KEY ("sxc_buffer")
+#define INT_STRINGS_KEY ("sxc_int_strings")
+/* registry field a host sets to true to have errors raised with a code (see
+    sxc_raise) thrown as formatted strings rather than "sxc_error" userdata */
+#define STRING_ERRORS_KEY ("sxc_string_errors")
+#define INT_STRINGS_MIN (-128)
+#define INT_STRINGS_MAX (65535)
 #define TABLE_IS_LIST (1)
 #define TABLE_NOT_LIST (0)
 #define TABLE_MAYBE_LIST (-1)
@@ -13,13 +22,17 @@
 
 
 int l_libfunc_invoke(lua_State* L);
-int libfunc_invoke(SxcLibFunc func, lua_State* L, const int argcount);
+int l_libfunc_invoke_nothrow(lua_State* L);
+int libfunc_invoke(SxcLibFunc func, lua_State* L, const int argcount, int is_nothrow);
 void get_value(int index, SxcValue* return_value);
 void pop_value(SxcValue* return_value);
 void push_value(SxcValue* value);
+SxcBuffer* to_buffer(lua_State* L, int index);
+void buffer_new(SxcBuffer* buffer, SxcValue* return_value);
 
 
 extern SxcStringBinding STRING_BINDING;
 extern SxcMapBinding MAP_BINDING;
+extern SxcMapBinding BUFFER_BINDING;
 extern SxcFuncBinding FUNC_BINDING;
 extern SxcContextBinding CONTEXT_BINDING;
@@ -0,0 +1,184 @@
+#include <limits.h>
+#include "lua51_sxc.h"
+
+
+/* Buffers (see sxc_return_buffer) are "sxc_buffer" userdata holding the
+    SxcBuffer itself.  Scripts index them like a list (1-based, with # for the
+    length), but they can't grow, and only take numbers and booleans. */
+
+
+/* returns the buffer at index, or NULL if the value there isn't one */
+SxcBuffer* to_buffer(lua_State* L, int index) {
+  SxcBuffer* buffer = (SxcBuffer*)lua_touserdata(L, index);
+
+  if (buffer != NULL) {
+    luaL_checkstack(L, 2, "");
+    if (!lua_getmetatable(L, index)) {
+      return NULL;
+    }
+    luaL_getmetatable(L, BUFFER_METATABLE_KEY);
+    if (!lua_rawequal(L, -1, -2)) {
+      buffer = NULL;
+    }
+    lua_pop(L, 2);
+  }
+  return buffer;
+}
+
+
+/* returns the 0-based index of the key at index, or -1 if it isn't an integer */
+static int to_element_index(lua_State* L, int index) {
+  lua_Number key;
+
+  if (lua_type(L, index) != LUA_TNUMBER) {
+    return -1;
+  }
+  key = lua_tonumber(L, index);
+  return (key >= 1 && key <= INT_MAX && key == (lua_Number)(int)key) ? (int)key - 1 : -1;
+}
+
+
+static int l_buffer_index(lua_State* L) {
+  SxcBuffer* buffer = (SxcBuffer*)luaL_checkudata(L, 1, BUFFER_METATABLE_KEY);
+  SxcValue value;
+
+  value.context = NULL; /* not needed for primitives */
+  sxc_buffer_get(buffer, to_element_index(L, 2), &value);
+  switch (value.type) {
+    case sxc_cbool:
+      lua_pushboolean(L, value.data.cbool);
+      break;
+    case sxc_cint:
+      lua_pushinteger(L, (lua_Integer)value.data.cint);
+      break;
+    case sxc_cdouble:
+      lua_pushnumber(L, (lua_Number)value.data.cdouble);
+      break;
+    case sxc_cint64:
+      lua_pushnumber(L, (lua_Number)value.data.cint64);
+      break;
+    default:
+      lua_pushnil(L);
+      break;
+  }
+  return 1;
+}
+
+
+static int l_buffer_newindex(lua_State* L) {
+  SxcBuffer* buffer = (SxcBuffer*)luaL_checkudata(L, 1, BUFFER_METATABLE_KEY);
+  int index = to_element_index(L, 2);
+  SxcValue value;
+
+  value.context = NULL; /* not needed for primitives */
+  if (lua_type(L, 3) == LUA_TBOOLEAN) {
+    sxc_value_set(&value, sxc_cbool, (bool)lua_toboolean(L, 3));
+  } else if (lua_type(L, 3) == LUA_TNUMBER) {
+    sxc_value_set(&value, sxc_cdouble, (double)lua_tonumber(L, 3));
+  } else {
+    return luaL_error(L, "buffer elements must be numbers or booleans");
+  }
+
+  if (index < 0 || index >= buffer->length) {
+    return luaL_error(L, "buffer index out of range (length %d)", buffer->length);
+  }
+  if (!sxc_buffer_set(buffer, index, &value)) {
+    return luaL_error(L, "value can't be stored in buffer");
+  }
+  return 0;
+}
+
+
+static int l_buffer_len(lua_State* L) {
+  SxcBuffer* buffer = (SxcBuffer*)luaL_checkudata(L, 1, BUFFER_METATABLE_KEY);
+  lua_pushinteger(L, (lua_Integer)buffer->length);
+  return 1;
+}
+
+
+static int l_buffer_gc(lua_State* L) {
+  sxc_buffer_free((SxcBuffer*)lua_touserdata(L, 1));
+  return 0;
+}
+
+
+void buffer_new(SxcBuffer* buffer, SxcValue* return_value) {
+  lua_State* L = (lua_State*)(return_value->context->underlying);
+  SxcBuffer* userdata;
+
+  luaL_checkstack(L, 3, "");
+
+  /* NOTE the metatable's __gc frees the buffer along with the userdata */
+  userdata = (SxcBuffer*)lua_newuserdata(L, sizeof(SxcBuffer));
+  *userdata = *buffer;
+
+  if (luaL_newmetatable(L, BUFFER_METATABLE_KEY)) {
+    lua_pushcfunction(L, l_buffer_index);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, l_buffer_newindex);
+    lua_setfield(L, -2, "__newindex");
+    lua_pushcfunction(L, l_buffer_len);
+    lua_setfield(L, -2, "__len");
+    lua_pushcfunction(L, l_buffer_gc);
+    lua_setfield(L, -2, "__gc");
+  }
+  lua_setmetatable(L, -2);
+
+  get_value(-1, return_value);
+}
+
+
+
+static void buffer_intget(void* underlying, int key, SxcValue* return_value) {
+  lua_State* L = (lua_State*)(return_value->context->underlying);
+  sxc_buffer_get((SxcBuffer*)lua_touserdata(L, PTR2INT(underlying)), key, return_value);
+}
+
+
+static void buffer_intset(void* underlying, int key, SxcValue* value) {
+  lua_State* L = (lua_State*)(value->context->underlying);
+
+  /* NOTE values that can't be stored (or keys out of range) are ignored, since
+      buffers can't grow */
+  sxc_buffer_set((SxcBuffer*)lua_touserdata(L, PTR2INT(underlying)), key, value);
+}
+
+
+static void buffer_strget(void* underlying, const char* key, SxcValue* return_value) {
+  sxc_value_set(return_value, sxc_null);
+}
+
+
+static void buffer_strset(void* underlying, const char* key, SxcValue* value) {
+  /* buffers have no string keys */
+}
+
+
+static void* buffer_iter(void* underlying, void* state, SxcValue* return_key, SxcValue* return_value) {
+  lua_State* L = (lua_State*)(return_value->context->underlying);
+  /* NOTE state is the index of the next element, plus 1 (so it's never NULL) */
+  int index = state == NULL ? 0 : PTR2INT(state) - 1;
+
+  if (!sxc_buffer_get((SxcBuffer*)lua_touserdata(L, PTR2INT(underlying)), index, return_value)) {
+    return NULL;
+  }
+  sxc_value_set(return_key, sxc_cint, index);
+  return INT2PTR(index + 2);
+}
+
+
+static SxcBuffer* buffer_getbuffer(void* underlying, SxcContext* context) {
+  return (SxcBuffer*)lua_touserdata((lua_State*)(context->underlying), PTR2INT(underlying));
+}
+
+
+static int buffer_listlength(void* underlying, SxcContext* context) {
+  return buffer_getbuffer(underlying, context)->length;
+}
+
+
+/* NOTE sxc_map_length() gets the length from getbuffer() */
+SxcMapBinding BUFFER_BINDING = {
+  buffer_intget, buffer_intset, buffer_strget, buffer_strset, NULL, buffer_iter,
+  NULL, NULL, buffer_getbuffer, buffer_listlength
+};
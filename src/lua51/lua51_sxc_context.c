@@ -15,8 +15,45 @@ static void to_sstring(const char* data, int length, SxcValue* return_value) {
 }
 
 
+/* Small ints' strings are kept in a registry table as they're first used, so
+    converting them again skips formatting and interning. */
+static int int_to_sstring(int cint, SxcValue* return_value) {
+  lua_State* L = (lua_State*)(return_value->context->underlying);
+
+  if (cint < INT_STRINGS_MIN || cint > INT_STRINGS_MAX) {
+    return SXC_FAILURE;
+  }
+
+  luaL_checkstack(L, 2 + 2, "");
+  lua_getfield(L, LUA_REGISTRYINDEX, INT_STRINGS_KEY);
+  lua_rawgeti(L, -1, cint);
+  if (lua_isnil(L, -1)) {
+    lua_pop(L, 1);
+    lua_pushfstring(L, "%d", cint);
+    lua_pushvalue(L, -1);
+    lua_rawseti(L, -3, cint);
+  }
+  lua_remove(L, -2);
+  get_value(-1, return_value);
+  return SXC_SUCCESS;
+}
+
+
+/* looks up property name (arg 2) in the given table of lightuserdata funcs */
+static SxcLibFunc* get_property_func(lua_State* L, int table_index) {
+  SxcLibFunc* func;
+
+  lua_pushvalue(L, 2/*property name*/);
+  lua_rawget(L, table_index);
+  func = (SxcLibFunc*)lua_touserdata(L, -1);
+  lua_pop(L, 1);
+  return func;
+}
+
+
 static int l_maptype_metatable_index(lua_State* L) {
   SxcLibFunc* getter;
+  int is_nothrow = 1;
 
   /* check for method first (return if found) */
   lua_pushvalue(L, 2/*property name*/);
@@ -28,18 +65,21 @@ static int l_maptype_metatable_index(lua_State* L) {
   } else {
     lua_pop(L, 1);
 
-    /* check getters next (invoke if found) */
-    lua_pushvalue(L, 2/*property name*/);
-    lua_rawget(L, lua_upvalueindex(2/*getters*/));
-    getter = (SxcLibFunc*)lua_touserdata(L, -1);
+    /* check getters next (invoke if found), nothrow getters first since
+        they're the ones expected to be hot */
+    getter = get_property_func(L, lua_upvalueindex(3/*nothrow getters*/));
+    if (getter == NULL) {
+      getter = get_property_func(L, lua_upvalueindex(2/*getters*/));
+      is_nothrow = 0;
+    }
 
     if (getter != NULL) {
-      libfunc_invoke(getter, L, 1);
+      libfunc_invoke(getter, L, 1, is_nothrow);
       /* keep getter return value */
       lua_settop(L, 3);
       return 1;
     } else {
-      /* nil is on top of stack */
+      lua_pushnil(L);
       return 1;
     }
   }
@@ -47,18 +87,20 @@ static int l_maptype_metatable_index(lua_State* L) {
 
 static int l_maptype_metatable_newindex(lua_State* L) {
   SxcLibFunc* setter;
+  int is_nothrow = 1;
 
   /* check for setter */
-  lua_pushvalue(L, 2/*property name*/); /* 2nd arg is property name */
-  lua_rawget(L, lua_upvalueindex(1));
-  setter = (SxcLibFunc*)lua_touserdata(L, -1);
-  lua_pop(L, 1);
+  setter = get_property_func(L, lua_upvalueindex(2/*nothrow setters*/));
+  if (setter == NULL) {
+    setter = get_property_func(L, lua_upvalueindex(1/*setters*/));
+    is_nothrow = 0;
+  }
 
   if (setter != NULL) {
     /* manipulate args on stack for setter */
     lua_replace(L, 2/*property name*/); /* make property value (3rd) arg the 2nd arg */
 
-    libfunc_invoke(setter, L, 2);
+    libfunc_invoke(setter, L, 2, is_nothrow);
 
     /* ignore setter return value */
     lua_settop(L, 3);
@@ -88,7 +130,7 @@ static int l_maptype_metatable_call(lua_State* L) {
     /* manipulate args on stack for initializer */
     lua_insert(L, 1); /* move object to 1st arg position */
 
-    libfunc_invoke(initializer, L, lua_gettop(L));
+    libfunc_invoke(initializer, L, lua_gettop(L), 0);
 
     /* ignore initializer return value and put object in place to be returned */
     lua_pop(L, 2);
@@ -99,9 +141,28 @@ static int l_maptype_metatable_call(lua_State* L) {
 }
 
 
+/* pushes a table of property name => lightuserdata func, for the properties
+    matching is_static and is_nothrow (setters instead of getters if is_setter) */
+static void property_funcs(lua_State* L, int is_static, int is_nothrow, int is_setter, const SxcLibProperty* properties) {
+  SxcLibFunc* func;
+  int i;
+
+  lua_newtable(L);
+  for (i = 0; properties[i].name != NULL; i += 1) {
+    func = is_setter ? properties[i].setter : properties[i].getter;
+    if (func != NULL && (!properties[i].is_nothrow) == (!is_nothrow)
+        && (is_static == properties[i].is_static || (is_static && properties[i].is_static))) {
+      lua_pushstring(L, properties[i].name);
+      lua_pushlightuserdata(L, func);
+      lua_rawset(L, -3);
+    }
+  }
+}
+
+
 static void maptype_metatable(lua_State* L, int is_static, const SxcLibMethod* methods, const SxcLibProperty* properties) {
   int i;
-  luaL_checkstack(L, 6, "");
+  luaL_checkstack(L, 7, "");
 
 printf("in maptype_metatable, is_static:%d\n", is_static);
 
@@ -115,21 +176,14 @@ printf("in maptype_metatable, is_static:%d\n", is_static);
       if (is_static == methods[i].is_static || (is_static && methods[i].is_static)) {
         lua_pushstring(L, methods[i].name);
           lua_pushlightuserdata(L, methods[i].func);
-        lua_pushcclosure(L, l_libfunc_invoke, 1);
+        lua_pushcclosure(L, methods[i].is_nothrow ? l_libfunc_invoke_nothrow : l_libfunc_invoke, 1);
         lua_rawset(L, -3);
       }
     }
-    /* 2nd up-value is getters */
-    lua_newtable(L);
-    for (i = 0; properties[i].name != NULL; i += 1) {
-      if (properties[i].getter != NULL
-          && (is_static == methods[i].is_static || (is_static && methods[i].is_static))) {
-        lua_pushstring(L, properties[i].name);
-        lua_pushlightuserdata(L, properties[i].getter);
-        lua_rawset(L, -3);
-      }
-    }
-  lua_pushcclosure(L, l_maptype_metatable_index, 2);
+    /* 2nd up-value is getters, 3rd is nothrow getters */
+    property_funcs(L, is_static, 0, 0, properties);
+    property_funcs(L, is_static, 1, 0, properties);
+  lua_pushcclosure(L, l_maptype_metatable_index, 3);
   lua_rawset (L, -3);
 
   /* TODO when there is a setter but no getter, create a getter that returns the
@@ -137,17 +191,10 @@ printf("in maptype_metatable, is_static:%d\n", is_static);
 
   /* create metatable.__newindex() as a C closure */
   lua_pushliteral(L, "__newindex");
-    /* 1st and only up-value is setters */
-    lua_newtable(L);
-    for (i = 0; properties[i].name != NULL; i += 1) {
-      if (properties[i].setter != NULL
-          && (is_static == methods[i].is_static || (is_static && methods[i].is_static))) {
-        lua_pushstring(L, properties[i].name);
-        lua_pushlightuserdata(L, properties[i].setter);
-        lua_rawset(L, -3);
-      }
-    }
-  lua_pushcclosure(L, l_maptype_metatable_newindex, 1);
+    /* 1st up-value is setters, 2nd is nothrow setters */
+    property_funcs(L, is_static, 0, 1, properties);
+    property_funcs(L, is_static, 1, 1, properties);
+  lua_pushcclosure(L, l_maptype_metatable_newindex, 2);
   lua_rawset (L, -3);
 
   /* metatable is now on top of stack */
@@ -201,17 +248,19 @@ printf("done map_newtype\n");
 }
 
 
-static void map_new(void* map_type, SxcValue* return_value) {
+static void map_new(void* map_type, int array_size, int hash_size, SxcValue* return_value) {
   lua_State* L = (lua_State*)(return_value->context->underlying);
 
   luaL_checkstack(L, 4 + 2, "");
 
+  /* NOTE pre-sizing means a returned array is allocated once, instead of
+      being rehashed as it grows */
   if (map_type == MAPTYPE_HASH || map_type == MAPTYPE_LIST) {
-    lua_newtable(L);
+    lua_createtable(L, array_size, hash_size);
   } else {
     /* TODO actually invoke the ctor with some given args, instead of simply
         returning an un-initialized table with associated metatable */
-    lua_newtable(L);
+    lua_createtable(L, array_size, hash_size);
 
     /* associate metatable */
     lua_getfield(L, LUA_REGISTRYINDEX, MAPTYPE_CTORS_KEY); /* put ctor store on stack */
@@ -235,6 +284,19 @@ static void to_sfunc(SxcLibFunc* func, SxcValue* return_value) {
 }
 
 
+static SxcState* get_state(void* underlying) {
+  lua_State* L = (lua_State*)underlying;
+  SxcState* state;
+
+  luaL_checkstack(L, 1, "");
+  lua_getfield(L, LUA_REGISTRYINDEX, STATE_KEY);
+  state = (SxcState*)lua_touserdata(L, -1);
+  lua_pop(L, 1);
+  return state;
+}
+
+
 SxcContextBinding CONTEXT_BINDING = {
-  get_arg, to_sstring, map_new, map_newtype, to_sfunc
+  get_arg, to_sstring, map_new, map_newtype, to_sfunc, get_state, int_to_sstring,
+  buffer_new
 };
@@ -2,7 +2,7 @@
 
 
 #include <stdio.h>
-static void func_invoke(void* underlying, SxcValue** args, int argcount, SxcValue* return_value) {
+static int func_invoke(void* underlying, SxcValue** args, int argcount, SxcValue* return_value) {
   lua_State* L = (lua_State*)(return_value->context->underlying);
   int i;
 
@@ -20,13 +20,25 @@ printf("done pushing function\n");
 printf("done pushing arg %d\n", i);
   }
 
-  /* invoke function */
-  lua_call(L, argcount, 1);
+  /* invoke function (protected, since an error escaping through the C library
+      would skip its sxc_finally() and leak its arena) */
+  if (lua_pcall(L, argcount, 1, 0) != 0) {
+    /* turn the error into a string if possible */
+    if (!lua_isstring(L, -1)) {
+      if (!luaL_callmeta(L, -1, "__tostring")) {
+        lua_pushliteral(L, "Script function raised a non-string error.");
+      }
+      lua_replace(L, -2);
+    }
+    pop_value(return_value);
+    return SXC_FAILURE;
+  }
 printf("done calling func\n");
 
   /* get return value */
   pop_value(return_value);
 printf("done get_value\n");
+  return SXC_SUCCESS;
 }
 
 
@@ -1,5 +1,10 @@
+#include <limits.h>
+#include <string.h>
 #include "lua51_sxc.h"
 
+int sxc_value_toelement(SxcValue* value, SxcDataType type, void* element);
+int sxc_value_elementsize(SxcDataType type);
+
 
 static void map_intget(void* underlying, int key, SxcValue* return_value) {
   lua_State* L = (lua_State*)(return_value->context->underlying);
@@ -83,6 +88,239 @@ printf("leaving map_iter nulled with new state:%d\n", PTR2INT(state));
 }
 
 
+/* NOTE the range functions use raw access for tables without a metatable,
+    but intgetrange() honours __index like intget() (and intsetrange() declines
+    tables with one) */
+static int has_metatable(lua_State* L, int index) {
+  if (lua_getmetatable(L, index)) {
+    lua_pop(L, 1);
+    return 1;
+  }
+  return 0;
+}
+
+
+/* pushes the element at 1-based key, raw or through __index */
+static void push_element(lua_State* L, int index, int key, int is_raw) {
+  if (is_raw) {
+    lua_rawgeti(L, index, key);
+  } else {
+    lua_pushinteger(L, (lua_Integer)key);
+    lua_gettable(L, index);
+  }
+}
+
+
+/* NOTE like #, this finds a border (which is the length of a list), but it
+    also honours __index, e.g. for proxy tables */
+static int map_listlength(void* underlying, SxcContext* context) {
+  lua_State* L = (lua_State*)(context->underlying);
+  int index = PTR2INT(underlying);
+  size_t length;
+  int low = 0;
+  int high = 1;
+  int mid;
+
+  if (!has_metatable(L, index)) {
+    length = lua_objlen(L, index);
+    return length > INT_MAX ? INT_MAX : (int)length;
+  }
+
+  /* elements up to low exist (or low is 0), and the one at high doesn't;
+      double high until it's missing, then binary search between them */
+  luaL_checkstack(L, 2, "");
+  for (;;) {
+    push_element(L, index, high, 0);
+    if (lua_isnil(L, -1)) {
+      lua_pop(L, 1);
+      break;
+    }
+    lua_pop(L, 1);
+    low = high;
+    if (high > INT_MAX / 2) {
+      return high;
+    }
+    high *= 2;
+  }
+  while (high - low > 1) {
+    mid = low + (high - low) / 2;
+    push_element(L, index, mid, 0);
+    if (lua_isnil(L, -1)) {
+      high = mid;
+    } else {
+      low = mid;
+    }
+    lua_pop(L, 1);
+  }
+  return low;
+}
+
+
+static int map_intgetrange(void* underlying, int start, int count, SxcDataType type, void* array, SxcContext* context) {
+  lua_State* L = (lua_State*)(context->underlying);
+  int index = PTR2INT(underlying);
+  SxcValue element;
+  lua_Number number;
+  SxcStringRef ref;
+  char* copy;
+  size_t length;
+  int is_raw = !has_metatable(L, index);
+  int size;
+  int i;
+
+  luaL_checkstack(L, 2 + 2, "");
+  element.context = context;
+
+  /***** straightforward but verbose (and error prone) ==> macro! *****/
+  #define GETRANGE(CTYPE, SCALAR_TYPE, IS_EXACT)                        \
+    for (i = 0; i < count; i += 1) {                                    \
+      push_element(L, index, start + i + 1, is_raw);                    \
+      /* NOTE only numbers are read as numbers (lua_tonumber would      \
+          convert numeric strings) */                                   \
+      if (lua_type(L, -1) == LUA_TNUMBER                                \
+          && (number = lua_tonumber(L, -1), (IS_EXACT))) {              \
+        ((CTYPE*)array)[i] = (CTYPE)number;                             \
+      } else {                                                          \
+        get_value(-1, &element);                                        \
+        if (!sxc_value_get(&element, SCALAR_TYPE, &((CTYPE*)array)[i])) { \
+          ((CTYPE*)array)[i] = (CTYPE)0;                                \
+        }                                                               \
+      }                                                                 \
+      lua_pop(L, 1);                                                    \
+    }                                                                   \
+    return SXC_SUCCESS;
+
+  switch (type) {
+    case sxc_cbools:
+      for (i = 0; i < count; i += 1) {
+        push_element(L, index, start + i + 1, is_raw);
+        if (lua_type(L, -1) == LUA_TNUMBER) {
+          ((bool*)array)[i] = (lua_tonumber(L, -1) != 0);
+        } else {
+          get_value(-1, &element);
+          if (!sxc_value_get(&element, sxc_cbool, &((bool*)array)[i])) {
+            ((bool*)array)[i] = 0;
+          }
+        }
+        lua_pop(L, 1);
+      }
+      return SXC_SUCCESS;
+
+    case sxc_cints:
+      GETRANGE(int, sxc_cint,
+        number >= INT_MIN && number <= INT_MAX && number == (lua_Number)(int)number)
+
+    case sxc_cdoubles:
+      GETRANGE(double, sxc_cdouble, 1)
+
+    case sxc_cint64s:
+      /* 2^63 bounds are exact doubles, unlike the int64 limits */
+      GETRANGE(SxcInt64, sxc_cint64,
+        number >= -9223372036854775808.0 && number < 9223372036854775808.0
+          && number == (lua_Number)(SxcInt64)number)
+
+    /* NOTE strings are borrowed, since Lua strings are immutable and
+        null-terminated, and the table keeps them alive (other elements are
+        converted into the arena, as are strings from __index, which may be
+        made up on the spot) */
+    case sxc_cstrings:
+    case sxc_cstringrefs:
+      for (i = 0; i < count; i += 1) {
+        push_element(L, index, start + i + 1, is_raw);
+        if (lua_type(L, -1) == LUA_TSTRING) {
+          ref.data = (char*)lua_tolstring(L, -1, &length);
+          ref.length = (int)length;
+          if (!is_raw) {
+            copy = (char*)sxc_alloc(context, ref.length + 1);
+            ref.data = copy == NULL ? NULL : (char*)memcpy(copy, ref.data, ref.length + 1);
+            ref.length = copy == NULL ? 0 : ref.length;
+          }
+        } else {
+          get_value(-1, &element);
+          if (!sxc_value_get(&element, sxc_cstring, &ref.data)) {
+            ref.data = NULL;
+          }
+          ref.length = ref.data == NULL ? 0 : (int)strlen(ref.data);
+        }
+        lua_pop(L, 1);
+
+        if (type == sxc_cstrings) {
+          ((char**)array)[i] = ref.data;
+        } else {
+          ((SxcStringRef*)array)[i] = ref;
+        }
+      }
+      return SXC_SUCCESS;
+
+    /* the remaining types aren't worth a fast path, but are read here anyway
+        so that no element is left on the stack (as intget() would) */
+    default:
+      size = sxc_value_elementsize(type);
+      if (size == 0) {
+        return SXC_FAILURE;
+      }
+      for (i = 0; i < count; i += 1) {
+        push_element(L, index, start + i + 1, is_raw);
+        get_value(-1, &element);
+        if (!sxc_value_toelement(&element, type, (char*)array + i * size)) {
+          memset((char*)array + i * size, 0, size);
+        }
+        lua_pop(L, 1);
+      }
+      return SXC_SUCCESS;
+  }
+
+  /***** macros be gone! *****/
+  #undef GETRANGE
+}
+
+
+static int map_intsetrange(void* underlying, int start, int count, SxcDataType type, void* array, SxcContext* context) {
+  lua_State* L = (lua_State*)(context->underlying);
+  int index = PTR2INT(underlying);
+  int i;
+
+  if (has_metatable(L, index)) {
+    return SXC_FAILURE;
+  }
+  luaL_checkstack(L, 1, "");
+
+  /***** straightforward but verbose (and error prone) ==> macro! *****/
+  #define SETRANGE(CTYPE, PUSH)                                         \
+    for (i = 0; i < count; i += 1) {                                    \
+      PUSH(L, ((CTYPE*)array)[i]);                                      \
+      lua_rawseti(L, index, start + i + 1);                             \
+    }                                                                   \
+    return SXC_SUCCESS;
+
+  #define PUSHBOOL(L, X) lua_pushboolean((L), (X) != 0)
+  #define PUSHINT(L, X) lua_pushinteger((L), (lua_Integer)(X))
+  #define PUSHNUMBER(L, X) lua_pushnumber((L), (lua_Number)(X))
+
+  switch (type) {
+    case sxc_cbools: SETRANGE(bool, PUSHBOOL)
+    case sxc_cints: SETRANGE(int, PUSHINT)
+    case sxc_cdoubles: SETRANGE(double, PUSHNUMBER)
+    case sxc_cint64s: SETRANGE(SxcInt64, PUSHNUMBER)
+    case sxc_cfloats: SETRANGE(float, PUSHNUMBER)
+    case sxc_cint8s: SETRANGE(signed char, PUSHINT)
+    case sxc_cuint8s: SETRANGE(unsigned char, PUSHINT)
+    case sxc_cint16s: SETRANGE(short, PUSHINT)
+    case sxc_cuint16s: SETRANGE(unsigned short, PUSHINT)
+
+    default:
+      return SXC_FAILURE;
+  }
+
+  /***** macros be gone! *****/
+  #undef SETRANGE
+  #undef PUSHBOOL
+  #undef PUSHINT
+  #undef PUSHNUMBER
+}
+
+
 SxcMapBinding MAP_BINDING = {
-  map_intget, map_intset, map_strget, map_strset, NULL, map_iter
+  map_intget, map_intset, map_strget, map_strset, NULL, map_iter,
+  map_intgetrange, map_intsetrange, NULL, map_listlength
 };
@@ -17,27 +17,52 @@
 #define SXC_SUCCESS (1)
 #define SXC_FAILURE (0)
 
+#if defined(_MSC_VER)
+  typedef __int64 SxcInt64;
+#else
+  typedef long long SxcInt64;
+#endif
+
 typedef enum _SxcDataType SxcDataType;
 typedef struct _SxcValue SxcValue;
 typedef struct _SxcString SxcString;
 typedef struct _SxcMap SxcMap;
 typedef struct _SxcFunc SxcFunc;
+typedef struct _SxcBuffer SxcBuffer;
+typedef struct _SxcView SxcView;
+typedef struct _SxcStringRef SxcStringRef;
 typedef struct _SxcContext SxcContext;
+typedef struct _SxcState SxcState;
+typedef struct _SxcArenaMark SxcArenaMark;
+typedef struct _SxcLibFuncStats SxcLibFuncStats;
+typedef struct _SxcError SxcError;
 
 #define MAPTYPE_HASH (NULL)
 #define MAPTYPE_LIST ((void*)1)
 
 
 
+/* same contract as Lua's lua_Alloc: frees ptr when new_size is 0, otherwise
+    behaves like realloc() */
+typedef void* (SxcAllocFunc)(void* userdata, void* ptr, size_t old_size, size_t new_size);
+
+
+
 /***** Library Types *****/
 
 typedef void (SxcLibFunc)(SxcContext* context);
 
+/* NOTE functions flagged is_nothrow are invoked without setting up a jump
+    buffer (see sxc_try_nothrow), so sxc_error() returns NULL instead of
+    jumping out of them, failed required sxc_arg()s return SXC_FAILURE, and
+    sxc_alloc() and friends return NULL when out of memory.  They must check
+    for failures and return early. */
 typedef struct _SxcLibMethod {
   char* name;
   int is_static;
   SxcLibFunc* func;
 
+  int is_nothrow;
 } SxcLibMethod;
 
 typedef struct _SxcLibProperty {
@@ -45,6 +70,8 @@ typedef struct _SxcLibProperty {
   int is_static;
   SxcLibFunc* getter;
   SxcLibFunc* setter;
+
+  int is_nothrow;
 } SxcLibProperty;
 
 
@@ -67,11 +94,31 @@ typedef struct _SxcMapBinding {
 
   int (*length)(void* underlying);
   void* (*iter)(void* underlying, void* state, SxcValue* return_key, SxcValue* return_value);
+
+  /* optional; read or write count elements starting at key start, to or from
+      array, which is of the given array type (e.g. sxc_cdoubles).  Elements
+      must be converted as intget()/intset() and sxc_value_get() would, with 0
+      for those that can't be.  Returns SXC_FAILURE (before touching anything)
+      if the binding can't do it, e.g. for an unsupported type. */
+  int (*intgetrange)(void* underlying, int start, int count, SxcDataType type, void* array, SxcContext* context);
+  int (*intsetrange)(void* underlying, int start, int count, SxcDataType type, void* array, SxcContext* context);
+
+  /* optional; returns the buffer the map wraps (see buffer_new below), or
+      NULL if it isn't one */
+  SxcBuffer* (*getbuffer)(void* underlying, SxcContext* context);
+
+  /* optional; returns the length the map has if it's a list, i.e. an index
+      whose element is missing though the one before it isn't (e.g. Lua's #
+      operator), without checking that it is one.  Views (see sxc_view_init)
+      use it to find the end of a list without reading elements. */
+  int (*listlength)(void* underlying, SxcContext* context);
 } SxcMapBinding;
 
 
 typedef struct _SxcFunctionBinding {
-  void (*invoke)(void* underlying, SxcValue** args, int argcount, SxcValue* return_value);
+  /* returns SXC_FAILURE (with the error in return_value) if the script
+      function raised an error, rather than letting it escape */
+  int (*invoke)(void* underlying, SxcValue** args, int argcount, SxcValue* return_value);
 } SxcFuncBinding;
 
 
@@ -80,11 +127,26 @@ typedef struct _SxcContextBinding {
 
   void (*to_sstring)(const char* data, int length, SxcValue* return_value);
 
-  void (*map_new)(void* map_type, SxcValue* return_value);
+  /* array_size and hash_size hint how many list and non-list elements the
+      map will hold, so it can be allocated once (0 if unknown) */
+  void (*map_new)(void* map_type, int array_size, int hash_size, SxcValue* return_value);
   void* (*map_newtype)(SxcContext* context, const char* name, SxcLibFunc* initializer,
                         const SxcLibMethod* methods, const SxcLibProperty* properties);
 
   void (*to_sfunc)(SxcLibFunc* func, SxcValue* return_value);
+
+  /* optional; returns the SxcState of the scripting environment instance */
+  SxcState* (*get_state)(void* underlying);
+
+  /* optional; sets return_value to a cached script string for cint, or
+      returns SXC_FAILURE if there isn't one (e.g. cint is out of range) */
+  int (*int_to_sstring)(int cint, SxcValue* return_value);
+
+  /* optional; sets return_value to a new sxc_smap that takes ownership of
+      buffer (whose struct may be copied) and lets scripts index it like a list.
+      Its map binding must provide getbuffer(), and the binding must call
+      sxc_buffer_free() once the script value is collected. */
+  void (*buffer_new)(SxcBuffer* buffer, SxcValue* return_value);
 } SxcContextBinding;
 
 
@@ -96,14 +158,32 @@ typedef struct _SxcContextBinding {
 #define SXC_DATA_DEST_ARGS ...
 
 void* sxc_alloc(SxcContext* context, int size);
+void* sxc_alloc_aligned(SxcContext* context, int size, int align);
+void* sxc_realloc(SxcContext* context, void* ptr, int size);
+void sxc_free(SxcContext* context, void* ptr);
+void* sxc_lib_alloc(SxcContext* context, const void* key, int size, bool* is_new);
+SxcArenaMark sxc_arena_mark(SxcContext* context);
+void sxc_arena_release(SxcContext* context, SxcArenaMark mark);
+void sxc_pool_setlimits(int max_size, int max_chunk_size);
+void sxc_pool_trim(SxcState* state, int max_size);
+int sxc_stats_get(SxcLibFunc* func, SxcLibFuncStats* return_stats);
+int sxc_stats_list(SxcLibFuncStats* return_stats, int max_count);
+int sxc_stats_dropped(void);
+void sxc_stats_reset(void);
 void* sxc_error(SxcContext* context, const char* message_format, ...);
+void* sxc_raise(SxcContext* context, int code, const char* format, ...);
+int sxc_error_format(const SxcError* error, char* buffer);
 int sxc_arg(SxcContext* context, int index, bool is_required, SxcDataType type, SXC_DATA_DEST);
 void sxc_return(SxcContext* context, SxcDataType type, SXC_DATA_ARG);
+void sxc_return_buffer(SxcContext* context, SxcDataType type, void* array, int length);
 
 int sxc_value_get(SxcValue* value, SxcDataType type, SXC_DATA_DEST);
 void sxc_value_set(SxcValue* value, SxcDataType type, SXC_DATA_ARG);
 
-SxcMap* sxc_map_new(SxcContext* context, void* map_type);
+int sxc_number_parsedoubles(char** cstrings, int count, double* return_doubles, unsigned char* return_failures);
+int sxc_number_parseints(char** cstrings, int count, int* return_ints, unsigned char* return_failures);
+
+SxcMap* sxc_map_new(SxcContext* context, void* map_type, int array_size, int hash_size);
 void* sxc_map_newtype(SxcContext* context, const char* name, SxcLibFunc initialzier,
                       const SxcLibMethod* methods, const SxcLibProperty* properties);
 int sxc_map_intget(SxcMap* map, int key, bool is_required, SxcDataType type, SXC_DATA_DEST);
@@ -113,7 +193,15 @@ void sxc_map_strset(SxcMap* map, const char* key, SxcDataType type, SXC_DATA_ARG
 int sxc_map_length(SxcMap* map);
 void* sxc_map_iter(SxcMap* map, void* state, SxcValue* return_key, SxcValue* return_value);
 
+int sxc_view_init(SxcView* view, SxcMap* map, SxcDataType type, int block_size);
+int sxc_view_get(SxcView* view, int index, void* return_element);
+int sxc_view_length(SxcView* view);
+
+int sxc_buffer_get(SxcBuffer* buffer, int index, SxcValue* return_value);
+int sxc_buffer_set(SxcBuffer* buffer, int index, SxcValue* value);
+
 void sxc_func_invoke(SxcFunc* func, int argcount, SxcDataType return_type, SXC_DATA_DEST_ARGS);
+int sxc_func_pinvoke(SxcFunc* func, SxcValue* return_error, int argcount, SxcDataType return_type, SXC_DATA_DEST_ARGS);
 
 
 
@@ -121,7 +209,11 @@ void sxc_func_invoke(SxcFunc* func, int argcount, SxcDataType return_type, SXC_D
 
 void sxc_load(SxcContext* context);
 void sxc_try(SxcContext* context, void* underlying, SxcContextBinding* binding, int argcount, SxcLibFunc func);
+void sxc_try_nothrow(SxcContext* context, void* underlying, SxcContextBinding* binding, int argcount, SxcLibFunc func);
 void sxc_finally(SxcContext* context);
+void sxc_state_init(SxcState* state, SxcAllocFunc* allocf, void* allocud);
+void sxc_state_close(SxcState* state);
+void sxc_buffer_free(SxcBuffer* buffer);
 
 
 
@@ -164,10 +256,39 @@ enum _SxcDataType {
   sxc_cpointer,  /* void* <=> SxcString* */
   sxc_cfunc,     /* SxcLibFunc* => SxcFunc* */
   sxc_cchars,    /* char* + int length <=> SxcString* */
-  sxc_cbools,    /* char* + int length <=> SxcMap* */
+  sxc_cbools,    /* bool* + int length <=> SxcMap* */
   sxc_cints,     /* int* + int length <=> SxcMap* */
   sxc_cdoubles,  /* double* + int length <=> SxcMap* */
-  sxc_cstrings   /* char** + int length <=> SxcMap* */
+  sxc_cstrings,  /* char** + int length <=> SxcMap* */
+
+  /* C LIBRARIES ONLY: These are the 64-bit Types.  They are for integers that
+      don't fit in an int (e.g. IDs and timestamps).  The scripting environment
+      sees them as numbers, and C libraries can read any integral number as one
+      without a round-trip through double or string. */
+  sxc_cint64,    /* SxcInt64 <=> primitive */
+  sxc_cint64s,   /* SxcInt64* + int length <=> SxcMap* */
+
+  /* C LIBRARIES ONLY: These are the Narrow Array Types.  They are for large
+      numeric payloads (e.g. feature vectors and images) that would otherwise
+      have to be widened into an sxc_cdoubles or sxc_cints copy.  Elements are
+      seen by the scripting environment as numbers.  Values out of an integer
+      element type's range are clamped to it (NaN becomes 0). */
+  sxc_cfloats,   /* float* + int length <=> SxcMap* */
+  sxc_cint8s,    /* signed char* + int length <=> SxcMap* */
+  sxc_cuint8s,   /* unsigned char* + int length <=> SxcMap* */
+  sxc_cint16s,   /* short* + int length <=> SxcMap* */
+  sxc_cuint16s,  /* unsigned short* + int length <=> SxcMap* */
+
+  /* C LIBRARIES ONLY: These are the Borrowed Types.  They point straight into
+      storage owned by the scripting environment where they can (e.g. the
+      strings in a list), instead of into copies, so they are only valid until
+      the library function returns and must not be modified.  NOTE changing
+      the map they came from may also invalidate them. */
+  sxc_cstringrefs, /* SxcStringRef* + int length <=> SxcMap* */
+
+  /* NOTE must come after all of the types above (see CONVERSION_ROWS in
+      sxc_value.c) */
+  _sxc_datatype_count
 
   /* C LIBRARIES ONLY: These are the meta types.  They don't represent actual
       data types, but add capability to the value type system. */
@@ -201,10 +322,50 @@ struct _SxcFunc {
 };
 
 
+/* an element of sxc_cstringrefs; data is NULL for an element that can't be
+    converted to a string, and isn't necessarily null-terminated */
+struct _SxcStringRef {
+  char* data;
+  int length;
+};
+
+
+/* A numeric C array owned by the scripting environment rather than a context
+    (see sxc_return_buffer).  Scripts see it as a fixed-length list, and C
+    libraries get its array back without a copy when they ask for its type. */
+struct _SxcBuffer {
+  SxcDataType type;  /* an array type, e.g. sxc_cdoubles */
+  void* array;
+  int length;
+
+  /* private */
+  void* _chunk;
+};
+
+
+/* A typed, read-only window onto a list map, for C libraries that only touch
+    some of its elements (see sxc_view_init).  Elements are fetched and
+    converted as they are read, instead of the whole map being converted into
+    a C array up front. */
+struct _SxcView {
+  SxcMap* map;
+  SxcDataType type;  /* an array type, e.g. sxc_cdoubles */
+
+  /* private */
+  int _length;       /* -2 until known */
+  int _elementsize;
+  int _blocksize;    /* elements per cached block, or 0 for no cache */
+  int _blockstart;   /* index of the 1st cached element */
+  int _blockcount;   /* count of cached elements */
+  char* _block;
+};
+
+
 typedef union _SxcData {
   bool cbool;
   int cint;
   double cdouble;
+  SxcInt64 cint64;
 
   /* HACK _pointer_store can be used to generically read/write to the pointer
       members below (due to the nature of C unions) */
@@ -265,6 +426,41 @@ typedef union _SxcData {
     char** array;
     int length;
   } cstrings;
+
+  struct {
+    SxcInt64* array;
+    int length;
+  } cint64s;
+
+  struct {
+    float* array;
+    int length;
+  } cfloats;
+
+  struct {
+    signed char* array;
+    int length;
+  } cint8s;
+
+  struct {
+    unsigned char* array;
+    int length;
+  } cuint8s;
+
+  struct {
+    short* array;
+    int length;
+  } cint16s;
+
+  struct {
+    unsigned short* array;
+    int length;
+  } cuint16s;
+
+  struct {
+    SxcStringRef* array;
+    int length;
+  } cstringrefs;
 } SxcData;
 
 
@@ -280,6 +476,9 @@ struct _SxcValue {
 typedef struct _SxcMemoryChunk {
   int free_space;
   struct _SxcMemoryChunk* next_chunk;
+  SxcAllocFunc* allocf;
+  void* allocud;
+  int serial; /* large chunks only: allocation order within the context */
 
   int offset;
   char data;
@@ -287,9 +486,103 @@ typedef struct _SxcMemoryChunk {
 } SxcMemoryChunk;
 
 
+/* per scripting environment instance data, owned by the language binding
+    (see sxc_state_init and sxc_state_close).  NOTE it isn't locked (e.g. its
+    pool of recycled chunks), so it's only for one thread at a time, just like
+    the scripting environment instance itself */
+struct _SxcState {
+  SxcAllocFunc* allocf;
+  void* allocud;
+
+  /* private */
+  void* _loadedlibs;
+  void* _persistchunks;
+  void* _persistblocks;
+  void* _poolchunks;
+  int _poolsize;
+};
+
+
+/* a saved arena position (see sxc_arena_mark) */
+struct _SxcArenaMark {
+  SxcMemoryChunk* chunk;
+  int offset;
+  int largeserial;
+  int usage;
+};
+
+
+/* arena usage of a library function, in bytes (see sxc_stats_get)
+    NOTE stats are kept per thread, so each thread only sees the calls it made,
+    and for at most SXC_STATS_MAX_FUNCS functions per thread: calls to any more
+    aren't recorded, but are counted by sxc_stats_dropped() */
+#define SXC_STATS_MAX_FUNCS (255)
+
+struct _SxcLibFuncStats {
+  SxcLibFunc* func;
+  int call_count;
+  int last_usage;     /* peak usage of the most recent call */
+  int max_usage;      /* peak usage of the heaviest call */
+  int typical_usage;  /* moving average of peak usage */
+};
+
+
 #define SXC_MEMORY_CHUNK_INIT_SIZE (1024 * 2)
 #define SXC_MEMORY_CHUNK_MAX_SIZE (1024 * 16)
 
+/* requests bigger than this get a dedicated chunk */
+#define SXC_MEMORY_LARGE_SIZE (SXC_MEMORY_CHUNK_MAX_SIZE / 4)
+
+/* sxc_alloc() alignment, suitable for any primitive type or struct */
+#define SXC_MEMORY_ALIGN (sizeof(double) > sizeof(void*) ? sizeof(double) : sizeof(void*))
+
+/* alignment of arrays produced by value conversions (e.g. sxc_cdoubles), so
+    they can be used directly with wide vector loads */
+#define SXC_MEMORY_ARRAY_ALIGN (64)
+
+/* default cap on the bytes each SxcState keeps in its pool of recycled chunks
+    (see sxc_pool_setlimits, which should be called before any thread invokes
+    functions).  The default state, for bindings without get_state, keeps a
+    pool per thread, which sxc_pool_trim(NULL, 0) frees. */
+#ifndef SXC_MEMORY_POOL_MAX_SIZE
+  #define SXC_MEMORY_POOL_MAX_SIZE (1024 * 256)
+#endif
+
+/* error codes (see sxc_raise); C libraries number their own codes starting
+    at SXC_ERROR_USER */
+#define SXC_ERROR_MESSAGE (0)  /* message already formatted (see sxc_error) */
+#define SXC_ERROR_TYPE (1)     /* value was not of the expected type */
+#define SXC_ERROR_USER (100)
+
+#define SXC_ERROR_MAX_ARGS (6)
+
+/* size in bytes of, and bit INDEX of, a bitmap of COUNT bits (e.g. failures
+    from sxc_number_parsedoubles) */
+#define SXC_BITMAP_SIZE(COUNT) (((COUNT) + 7) / 8)
+#define SXC_BITMAP_GET(BITMAP, INDEX) (((BITMAP)[(INDEX) / 8] >> ((INDEX) % 8)) & 1)
+
+/* a captured printf argument; conversion is the printf conversion character
+    it was captured for */
+typedef struct _SxcErrorArg {
+  char conversion;
+  union {
+    long i;
+    unsigned long u;
+    SxcInt64 ll;  /* for ll length modifiers (long may be only 32 bits) */
+    double d;
+    const char* s;
+    const void* p;
+  } value;
+} SxcErrorArg;
+
+/* an error whose message has not been formatted yet (see sxc_error_format) */
+struct _SxcError {
+  int code;
+  const char* format;
+  int argcount;
+  SxcErrorArg args[SXC_ERROR_MAX_ARGS];
+};
+
 struct _SxcContext {
   /* public */
   void* underlying;
@@ -297,9 +590,18 @@ struct _SxcContext {
   int argcount;
   SxcValue return_value;
   int has_error;
+  SxcError error;  /* set along with has_error */
 
   /* private */
   void* _jmpbuf;
+  SxcState* _state;
+  SxcMemoryChunk* _curchunk;
+  SxcMemoryChunk* _largechunks;
+  int _largeserial;
+  SxcLibFunc* _func;
+  int _usage;
+  int _peakusage;
+  int _chunkhint;
   SxcMemoryChunk _firstchunk;
   char _firstdata[SXC_MEMORY_CHUNK_INIT_SIZE - 1];
 };
@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
@@ -19,74 +20,907 @@
 #endif
 
 
-void sxc_typeerror(SxcContext* context, char* value_name, SxcDataType expected_type, SxcValue* actual_value);
+void sxc_typeerror(SxcContext* context, SxcDataType expected_type, SxcValue* actual_value, const char* value_name_format, ...);
 int sxc_value_getv(SxcValue* value, SxcDataType type, va_list varg);
 void sxc_value_setv(SxcValue* value, SxcDataType type, va_list varg);
 void sxc_value_snormalize(SxcValue* value);
 void sxc_value_cnormalize(SxcValue* value);
+void sxc_load_close(SxcState* state);
+int sxc_value_elementsize(SxcDataType type);
 
+static void* out_of_memory(SxcContext* context);
+
+
+#if defined(_MSC_VER)
+  #define THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+  #define THREAD_LOCAL __thread
+#else
+  /* NOTE without thread-local storage, per-thread data (the default state's
+      pool and the stats table) is shared by all threads */
+  #define THREAD_LOCAL
+#endif
+
+
+
+/* All memory SxC allocates on behalf of a scripting environment instance
+    (arena chunks, loaded library records) goes through the allocator of that
+    instance's SxcState, so that it is visible to the host's allocator.
+    Bindings that don't provide a state get a shared one backed by malloc. */
+static void* default_alloc(void* userdata, void* ptr, size_t old_size, size_t new_size) {
+  if (new_size == 0) {
+    free(ptr);
+    return NULL;
+  }
+  return realloc(ptr, new_size);
+}
+
+static SxcState default_state = { default_alloc, NULL, NULL, NULL, NULL, NULL, 0 };
+
+
+/* Overflow chunks are recycled through a pool kept in their SxcState rather
+    than being allocated and freed on every invocation, so they only ever go
+    back to an allocator that's still alive (sxc_state_close() drains the
+    pool).  Chunks larger than max_chunk_size are never retained, and a pool
+    stops retaining chunks once max_size bytes are held (see
+    sxc_pool_setlimits() and sxc_pool_trim()).
+
+    NOTE pools aren't locked, so the shared default state (for bindings without
+    get_state, whose contexts may be on any thread) has a pool per thread
+    instead, which is fine since its chunks all come from malloc.  The limits
+    are shared by every pool, so they should be set before any thread starts
+    invoking library functions. */
+typedef struct _SxcMemoryPoolLimits {
+  int max_size;
+  int max_chunk_size;
+} SxcMemoryPoolLimits;
+
+static SxcMemoryPoolLimits poollimits = {
+  SXC_MEMORY_POOL_MAX_SIZE, SXC_MEMORY_CHUNK_MAX_SIZE
+};
+
+static THREAD_LOCAL void* default_poolchunks;
+static THREAD_LOCAL int default_poolsize;
+
+#define POOL_CHUNKS(state) (*(SxcMemoryChunk**)((state) == &default_state \
+    ? &default_poolchunks : &(state)->_poolchunks))
+#define POOL_SIZE(state) (*((state) == &default_state \
+    ? &default_poolsize : &(state)->_poolsize))
+
+#define CHUNK_CAPACITY(chunk) ((chunk)->offset + (chunk)->free_space)
+#define CHUNK_ALLOC_SIZE(capacity) \
+  (sizeof(SxcMemoryChunk) + (capacity) - 1 /* one byte already in struct */)
+
+
+/* chunks are given back to whichever allocator they came from */
+static void chunk_free(SxcMemoryChunk* chunk) {
+  (chunk->allocf)(chunk->allocud, chunk, CHUNK_ALLOC_SIZE(CHUNK_CAPACITY(chunk)), 0);
+}
+
+
+static SxcMemoryChunk* pool_take(SxcState* state, int min_free_space) {
+  SxcMemoryChunk** link = &POOL_CHUNKS(state);
+  SxcMemoryChunk* chunk;
+
+  /* first fit is good enough, since all retained chunks are at most
+      max_chunk_size */
+  while (*link != NULL && CHUNK_CAPACITY(*link) < min_free_space) {
+    link = &((*link)->next_chunk);
+  }
+
+  chunk = *link;
+  if (chunk != NULL) {
+    *link = chunk->next_chunk;
+    POOL_SIZE(state) -= CHUNK_CAPACITY(chunk);
+
+    chunk->free_space = CHUNK_CAPACITY(chunk);
+    chunk->offset = 0;
+    chunk->next_chunk = NULL;
+  }
+  return chunk;
+}
+
+
+static void pool_give(SxcState* state, SxcMemoryChunk* chunk) {
+  int capacity = CHUNK_CAPACITY(chunk);
+
+  if (capacity > poollimits.max_chunk_size
+      || POOL_SIZE(state) + capacity > poollimits.max_size) {
+    chunk_free(chunk);
+  } else {
+    chunk->next_chunk = POOL_CHUNKS(state);
+    POOL_CHUNKS(state) = chunk;
+    POOL_SIZE(state) += capacity;
+  }
+}
+
+
+/* NOTE the limits apply to every state's pool, but only as chunks are given
+    back; pools that already hold more can be trimmed with sxc_pool_trim().
+    They aren't locked, so set them before any thread invokes functions. */
+void sxc_pool_setlimits(int max_size, int max_chunk_size) {
+  poollimits.max_size = max_size < 0 ? 0 : max_size;
+  poollimits.max_chunk_size = max_chunk_size < 0 ? 0 : max_chunk_size;
+}
+
+
+/* NOTE a NULL state trims the calling thread's pool for the default state
+    (e.g. before the thread exits, since nothing else frees it) */
+void sxc_pool_trim(SxcState* state, int max_size) {
+  SxcMemoryChunk** link;
+  SxcMemoryChunk* chunk;
+
+  if (state == NULL) {
+    state = &default_state;
+  }
+  link = &POOL_CHUNKS(state);
+
+  /* drop chunks that no longer satisfy the limits, then drop from the front
+      until the pool is small enough */
+  while ((chunk = *link) != NULL) {
+    if (CHUNK_CAPACITY(chunk) > poollimits.max_chunk_size || POOL_SIZE(state) > max_size) {
+      *link = chunk->next_chunk;
+      POOL_SIZE(state) -= CHUNK_CAPACITY(chunk);
+      chunk_free(chunk);
+    } else {
+      link = &(chunk->next_chunk);
+    }
+  }
+}
+
+
+
+void sxc_state_init(SxcState* state, SxcAllocFunc* allocf, void* allocud) {
+  state->allocf = allocf == NULL ? default_alloc : allocf;
+  state->allocud = allocf == NULL ? NULL : allocud;
+  state->_loadedlibs = NULL;
+  state->_persistchunks = NULL;
+  state->_persistblocks = NULL;
+  state->_poolchunks = NULL;
+  state->_poolsize = 0;
+}
+
+
+void sxc_state_close(SxcState* state) {
+  SxcMemoryChunk* chunk = state->_persistchunks;
+  SxcMemoryChunk* next;
+
+  sxc_load_close(state);
+
+  while (chunk != NULL) {
+    next = chunk->next_chunk;
+    chunk_free(chunk);
+    chunk = next;
+  }
+  state->_persistchunks = NULL;
+  state->_persistblocks = NULL;
+
+  sxc_pool_trim(state, 0);
+}
+
+
+SxcState* sxc_context_state(SxcContext* context) {
+  if (context->_state == NULL) {
+    context->_state = context->binding->get_state == NULL
+        ? &default_state
+        : (context->binding->get_state)(context->underlying);
+  }
+  return context->_state;
+}
+
+
+/* Arena usage is recorded per library function (in a per-thread table of up
+    to SXC_STATS_MAX_FUNCS functions), and used to size the first overflow
+    chunk of subsequent invocations of the same function, so functions that
+    reliably need more than the inline SXC_MEMORY_CHUNK_INIT_SIZE bytes get it
+    in one step rather than by repeated doubling.  Large allocations (see
+    SXC_MEMORY_LARGE_SIZE) aren't affected by chunk sizing, so they aren't
+    counted. */
+#define STATS_CAPACITY (SXC_STATS_MAX_FUNCS + 1) /* must be a power of 2 */
+
+static THREAD_LOCAL SxcLibFuncStats func_stats[STATS_CAPACITY];
+static THREAD_LOCAL int func_stats_count;
+static THREAD_LOCAL int func_stats_dropped;
+
+
+static SxcLibFuncStats* find_stats(SxcLibFunc* func, bool is_insert) {
+  int i = (int)(((size_t)func >> 4) & (STATS_CAPACITY - 1));
+
+  /* open addressing with linear probing; entries are never removed, except
+      all at once by sxc_stats_reset() */
+  while (func_stats[i].func != NULL) {
+    if (func_stats[i].func == func) {
+      return &func_stats[i];
+    }
+    i = (i + 1) & (STATS_CAPACITY - 1);
+  }
+
+  /* keep a free slot so probing always terminates */
+  if (!is_insert || func_stats_count >= STATS_CAPACITY - 1) {
+    return NULL;
+  }
+
+  func_stats_count += 1;
+  func_stats[i].func = func;
+  return &func_stats[i];
+}
+
+
+static void record_stats(SxcLibFunc* func, int usage) {
+  SxcLibFuncStats* stats = find_stats(func, true);
+
+  if (stats == NULL) {
+    func_stats_dropped += 1;
+  } else {
+    stats->call_count += 1;
+    stats->last_usage = usage;
+    stats->max_usage = usage > stats->max_usage ? usage : stats->max_usage;
+    /* moving average, so that one outlier doesn't inflate every later call */
+    stats->typical_usage += (usage - stats->typical_usage) / 4;
+    if (stats->call_count == 1) {
+      stats->typical_usage = usage;
+    }
+  }
+}
+
+
+int sxc_stats_get(SxcLibFunc* func, SxcLibFuncStats* return_stats) {
+  SxcLibFuncStats* stats = find_stats(func, false);
+
+  if (stats == NULL) {
+    return SXC_FAILURE;
+  }
+  *return_stats = *stats;
+  return SXC_SUCCESS;
+}
+
+
+int sxc_stats_list(SxcLibFuncStats* return_stats, int max_count) {
+  int i;
+  int count = 0;
+
+  for (i = 0; i < STATS_CAPACITY && count < max_count; i += 1) {
+    if (func_stats[i].func != NULL) {
+      return_stats[count] = func_stats[i];
+      count += 1;
+    }
+  }
+  return count;
+}
+
+
+/* Returns how many calls weren't recorded because the table was full (since
+    the last sxc_stats_reset()), i.e. nonzero if some functions have no stats. */
+int sxc_stats_dropped(void) {
+  return func_stats_dropped;
+}
+
+
+void sxc_stats_reset(void) {
+  memset(func_stats, 0, sizeof(func_stats));
+  func_stats_count = 0;
+  func_stats_dropped = 0;
+}
+
+
+/* Every allocation is preceded by a tag recording its size, alignment and
+    where it starts in its chunk (before any alignment padding), so that the
+    most recent allocation in a chunk can be resized in place or given back
+    (see sxc_realloc() and sxc_free()). */
+typedef struct _SxcMemoryTag {
+  int size;
+  int start;
+  int align;
+} SxcMemoryTag;
+
+#define TAG_OF(ptr) ((SxcMemoryTag*)(ptr) - 1)
+#define IS_CHUNK_TAIL(chunk, ptr) \
+  ((char*)(ptr) > &((chunk)->data) \
+    && (char*)(ptr) + TAG_OF(ptr)->size == &((chunk)->data) + (chunk)->offset)
+
+
+/* returns NULL if the chunk doesn't have room */
+static void* chunk_alloc(SxcMemoryChunk* chunk, int size, int align) {
+  char* tag_addr = &(chunk->data) + chunk->offset;
+  int padding = (int)((align - ((size_t)tag_addr + sizeof(SxcMemoryTag)) % align) % align);
+  int total_size = padding + sizeof(SxcMemoryTag) + size;
+  SxcMemoryTag* tag;
+
+  if (total_size > chunk->free_space) {
+    return NULL;
+  }
+
+  tag = (SxcMemoryTag*)(tag_addr + padding);
+  tag->size = size;
+  tag->start = chunk->offset;
+  tag->align = align;
+  chunk->free_space -= total_size;
+  chunk->offset += total_size;
+
+  return tag + 1;
+}
 
 
-/* TODO? change allocated chunks to be stored in a global linked list (with
-    atomic, lock-free next pointers) and rarely freed, and reduce the initial
-    space allocated on the stack (to zero?) */
 void* sxc_alloc(SxcContext* context, int size) {
-  SxcMemoryChunk* walker = &(context->_firstchunk);
-  void* retval;
+  return sxc_alloc_aligned(context, size, SXC_MEMORY_ALIGN);
+}
+
+
+static SxcMemoryChunk* new_chunk(SxcContext* context, int free_space) {
+  SxcState* state = sxc_context_state(context);
+  /* prefer a recycled chunk, as long as it's at least as big */
+  SxcMemoryChunk* chunk = pool_take(state, free_space);
+
+  if (chunk == NULL) {
+    chunk = (state->allocf)(state->allocud, NULL, 0, CHUNK_ALLOC_SIZE(free_space));
+    if (chunk == NULL) {
+      return out_of_memory(context);
+    }
+
+    chunk->allocf = state->allocf;
+    chunk->allocud = state->allocud;
+    chunk->free_space = free_space;
+    chunk->offset = 0;
+    chunk->next_chunk = NULL;
+  }
+  chunk->serial = 0;
+  return chunk;
+}
+
+
+/* Persistent allocations live as long as the SxcState, so libraries can build
+    lookup tables and the like once (typically from their register function)
+    instead of on every call.  Each one is identified by a caller-chosen key,
+    which makes it safe for a library to be registered in several states. */
+typedef struct _SxcPersistentBlock {
+  const void* key;
+  int size;
+  struct _SxcPersistentBlock* next;
+} SxcPersistentBlock;
+
+#define PERSISTENT_HEADER_SIZE \
+  ((int)(SXC_MEMORY_ALIGN * ((sizeof(SxcPersistentBlock) + SXC_MEMORY_ALIGN - 1) / SXC_MEMORY_ALIGN)))
+
+
+void* sxc_lib_alloc(SxcContext* context, const void* key, int size, bool* is_new) {
+  SxcState* state = sxc_context_state(context);
+  SxcMemoryChunk* chunk = state->_persistchunks;
+  SxcPersistentBlock* block = state->_persistblocks;
+  int total_size = PERSISTENT_HEADER_SIZE + size;
   int new_free_space;
 
-printf("in sxc_context_alloc, size: %d, first chunk free: %d\n", size, walker->free_space);
+  /* look for an existing allocation first */
+  while (block != NULL && block->key != key) {
+    block = block->next;
+  }
+
+  if (block != NULL) {
+    if (block->size < size) {
+      return sxc_error(context, "Error: persistent allocation of %d bytes "
+          "requested where %d bytes were allocated before", size, block->size);
+    }
+    if (is_new != NULL) *is_new = false;
+    return (char*)block + PERSISTENT_HEADER_SIZE;
+  }
+
+  /* otherwise bump allocate from the newest persistent chunk (NOTE these are
+      never pooled, since they belong to the state rather than a context) */
+  block = chunk == NULL ? NULL : chunk_alloc(chunk, total_size, SXC_MEMORY_ALIGN);
+  if (block == NULL) {
+    new_free_space = chunk == NULL ? SXC_MEMORY_CHUNK_INIT_SIZE : CHUNK_CAPACITY(chunk) * 2;
+    new_free_space = new_free_space > SXC_MEMORY_CHUNK_MAX_SIZE ? SXC_MEMORY_CHUNK_MAX_SIZE : new_free_space;
+    new_free_space = new_free_space < total_size + (int)sizeof(SxcMemoryTag) + (int)SXC_MEMORY_ALIGN
+        ? total_size + (int)sizeof(SxcMemoryTag) + (int)SXC_MEMORY_ALIGN : new_free_space;
+
+    chunk = (state->allocf)(state->allocud, NULL, 0, CHUNK_ALLOC_SIZE(new_free_space));
+    if (chunk == NULL) {
+      return out_of_memory(context);
+    }
+    chunk->allocf = state->allocf;
+    chunk->allocud = state->allocud;
+    chunk->free_space = new_free_space;
+    chunk->offset = 0;
+    chunk->serial = 0;
+    chunk->next_chunk = state->_persistchunks;
+    state->_persistchunks = chunk;
+
+    block = chunk_alloc(chunk, total_size, SXC_MEMORY_ALIGN);
+  }
+
+  memset(block, 0, total_size);
+  block->key = key;
+  block->size = size;
+  block->next = state->_persistblocks;
+  state->_persistblocks = block;
+
+  if (is_new != NULL) *is_new = true;
+  return (char*)block + PERSISTENT_HEADER_SIZE;
+}
+
+
+#define USAGE_ADD(context, delta) \
+  ((context)->_usage += (delta), \
+    (context)->_peakusage = (context)->_usage > (context)->_peakusage \
+      ? (context)->_usage : (context)->_peakusage)
+
+
+void* sxc_alloc_aligned(SxcContext* context, int size, int align) {
+  SxcMemoryChunk* chunk;
+  void* retval;
+  int new_free_space;
+  int total_size;
+  int prev_offset;
 
   /* TODO? should size <= 0 raise an error? (if so sxc_value.c must be fixed) */
   if (size <= 0) return NULL;
 
-  /* find appropriate memory chunk */
-  while (walker->free_space < size && walker->next_chunk != NULL) {
-    walker = walker->next_chunk;
+  if (align < (int)SXC_MEMORY_ALIGN) {
+    align = SXC_MEMORY_ALIGN;
+  } else if ((align & (align - 1)) != 0) {
+    return sxc_error(context, "Error: alignment (%d) is not a power of two", align);
+  }
+
+  /* enough room for the request no matter how a chunk is aligned */
+  total_size = size + sizeof(SxcMemoryTag) + align - 1;
+
+  /* large requests get a chunk of their own, so they neither inflate the size
+      of subsequent chunks nor waste the tail of the current one */
+  if (total_size > SXC_MEMORY_LARGE_SIZE) {
+    chunk = new_chunk(context, total_size);
+    if (chunk == NULL) {
+      return NULL;
+    }
+    chunk->serial = ++(context->_largeserial);
+    chunk->next_chunk = context->_largechunks;
+    context->_largechunks = chunk;
+    return chunk_alloc(chunk, size, align);
   }
 
-  /* add new chunk to list if necessary */
-  if (walker->free_space < size) {
-printf("...allocating new node\n");
+  /* otherwise bump allocate from the current chunk... */
+  chunk = context->_curchunk;
+  prev_offset = chunk->offset;
+  retval = chunk_alloc(chunk, size, align);
 
-    /* double prev node's free space up to a max */
-    new_free_space = (walker->offset + walker->free_space);
+  /* ...or start a new one, doubling the current chunk's size up to a max */
+  if (retval == NULL) {
+    new_free_space = CHUNK_CAPACITY(chunk);
     do {
       new_free_space *= 2;
-    } while (new_free_space <= size && new_free_space < SXC_MEMORY_CHUNK_MAX_SIZE);
+    } while (new_free_space <= total_size && new_free_space < SXC_MEMORY_CHUNK_MAX_SIZE);
 
-    /* but alloc at least as much as requested */
-    new_free_space = size > new_free_space ? size : new_free_space;
+    /* the first overflow chunk is sized by what previous calls needed */
+    if (chunk == &(context->_firstchunk) && context->_chunkhint > new_free_space) {
+      new_free_space = context->_chunkhint;
+    }
 
-printf("...new node space: %d\n", new_free_space);
+    /* but alloc at least as much as requested */
+    new_free_space = total_size > new_free_space ? total_size : new_free_space;
 
-    walker->next_chunk = malloc(sizeof(SxcMemoryChunk) + new_free_space - 1 /* one byte already in struct */);
-    if (walker->next_chunk == NULL) {
-      return sxc_error(context, "Error: out of memory");
+    chunk = new_chunk(context, new_free_space);
+    if (chunk == NULL) {
+      return NULL;
     }
+    context->_curchunk->next_chunk = chunk;
+    context->_curchunk = chunk;
+    prev_offset = 0;
+    retval = chunk_alloc(chunk, size, align);
+  }
 
-    walker = walker->next_chunk;
-    walker->free_space = new_free_space;
-    walker->offset = 0;
-    walker->next_chunk = NULL;
+  USAGE_ADD(context, chunk->offset - prev_offset);
+  return retval;
+}
+
+
+/* returns the link to the large chunk holding ptr, or NULL if there isn't one */
+static SxcMemoryChunk** find_large_chunk(SxcContext* context, void* ptr) {
+  SxcMemoryChunk** link = &(context->_largechunks);
+
+  while (*link != NULL
+      && ((char*)ptr <= &((*link)->data) || (char*)ptr > &((*link)->data) + (*link)->offset)) {
+    link = &((*link)->next_chunk);
   }
+  return *link == NULL ? NULL : link;
+}
 
-  retval = &(walker->data) + walker->offset;
-  walker->free_space -= size;
-  walker->offset += size;
 
-printf("...done sxc_context_alloc, free space: %d\n", walker->free_space);
+void* sxc_realloc(SxcContext* context, void* ptr, int size) {
+  SxcMemoryChunk* chunk = context->_curchunk;
+  SxcMemoryChunk** large_link;
+  SxcMemoryTag* tag;
+  void* retval;
+  int growth;
 
+  if (ptr == NULL) {
+    return sxc_alloc(context, size);
+  }
+  if (size <= 0) {
+    sxc_free(context, ptr);
+    return NULL;
+  }
+
+  tag = TAG_OF(ptr);
+  growth = size - tag->size;
+
+  /* only the current chunk and large chunks can have ptr as their tail */
+  if (!IS_CHUNK_TAIL(chunk, ptr)) {
+    large_link = find_large_chunk(context, ptr);
+    chunk = large_link == NULL ? NULL : *large_link;
+  }
+
+  /* resize in place when this is the last allocation in its chunk and there's
+      room (shrinking never needs to move the data anyway) */
+  if (chunk != NULL && growth <= chunk->free_space) {
+    chunk->offset += growth;
+    chunk->free_space -= growth;
+    tag->size = size;
+    if (chunk == context->_curchunk) {
+      USAGE_ADD(context, growth);
+    }
+    return ptr;
+  } else if (size <= tag->size) {
+    tag->size = size;
+    return ptr;
+  }
+
+  /* otherwise move it (the new allocation never overlaps the old one, so the
+      old data is still intact to copy from), leaving ptr as is if that fails */
+  retval = sxc_alloc_aligned(context, size, tag->align);
+  if (retval == NULL) {
+    return NULL;
+  }
+  memcpy(retval, ptr, tag->size);
+  sxc_free(context, ptr);
   return retval;
 }
 
-/* TODO
-void* sxc_context_realloc(SxcContext* context)
-  * might need to store len before alloc'd data
-  * could store 0 for data that takes up the entire chunk (i.e. chunk was alloc'd just for that data)
 
-void sxc_context_free()
-*/
+void sxc_free(SxcContext* context, void* ptr) {
+  SxcMemoryChunk* chunk = context->_curchunk;
+  SxcMemoryChunk** large_link;
+
+  if (ptr == NULL) return;
+
+  /* NOTE only the last allocation in the current chunk (or a large allocation)
+      can actually be given back; anything else is reclaimed when the context
+      is finalized */
+  if (IS_CHUNK_TAIL(chunk, ptr)) {
+    context->_usage -= chunk->offset - TAG_OF(ptr)->start;
+    chunk->free_space += chunk->offset - TAG_OF(ptr)->start;
+    chunk->offset = TAG_OF(ptr)->start;
+  } else if ((large_link = find_large_chunk(context, ptr)) != NULL) {
+    chunk = *large_link;
+    *large_link = chunk->next_chunk;
+    pool_give(context->_state, chunk);
+  }
+}
+
+
+/* NOTE a context has a state by the time it has chunks (see new_chunk) */
+static void free_chunks(SxcState* state, SxcMemoryChunk* chunk) {
+  SxcMemoryChunk* next;
+  while (chunk != NULL) {
+    next = chunk->next_chunk;
+    pool_give(state, chunk);
+    chunk = next;
+  }
+}
+
+
+SxcArenaMark sxc_arena_mark(SxcContext* context) {
+  SxcArenaMark mark;
+  mark.chunk = context->_curchunk;
+  mark.offset = context->_curchunk->offset;
+  mark.largeserial = context->_largeserial;
+  mark.usage = context->_usage;
+  return mark;
+}
+
+
+/* NOTE allocations made before the mark must not be grown with sxc_realloc()
+    while the mark is outstanding, since releasing would truncate them */
+void sxc_arena_release(SxcContext* context, SxcArenaMark mark) {
+  SxcMemoryChunk* chunk;
+
+  /* chunks started since the mark go back to the pool... */
+  free_chunks(context->_state, mark.chunk->next_chunk);
+  mark.chunk->next_chunk = NULL;
+  context->_curchunk = mark.chunk;
+
+  /* ...and the chunk that was current at the mark is rolled back */
+  if (mark.chunk->offset > mark.offset) {
+    mark.chunk->free_space += mark.chunk->offset - mark.offset;
+    mark.chunk->offset = mark.offset;
+  }
+  context->_usage = mark.usage;
+
+  /* large chunks are kept newest first, so pop any made since the mark */
+  while ((chunk = context->_largechunks) != NULL && chunk->serial > mark.largeserial) {
+    context->_largechunks = chunk->next_chunk;
+    pool_give(context->_state, chunk);
+  }
+}
+
+
+/* printf length modifier (and unsigned type) for SxcInt64 args */
+#if defined(_MSC_VER)
+  #define INT64_MODIFIER "I64"
+  typedef unsigned __int64 UInt64;
+#else
+  #define INT64_MODIFIER "ll"
+  typedef unsigned long long UInt64;
+#endif
+
+/* whether the spec error_spec() parsed has an l or ll length modifier */
+#define SPEC_IS_LONG(SPEC, LENGTH, PREFIX) \
+  ((LENGTH) > (PREFIX) + 1 && (SPEC)[(LENGTH) - 2] == 'l')
+#define SPEC_IS_LONGLONG(SPEC, LENGTH, PREFIX) \
+  ((LENGTH) > (PREFIX) + 2 && (SPEC)[(LENGTH) - 2] == 'l' && (SPEC)[(LENGTH) - 3] == 'l')
+
+
+/* Parses the conversion spec just past a '%', setting length to its length
+    (conversion char included), prefix to the length of its flags, width, and
+    precision, and pad to its width plus precision.  Returns the conversion
+    char, or 0 if it's not one sxc_raise() supports. */
+static char error_spec(const char* spec, int* length, int* prefix, int* pad) {
+  const char* end = spec;
+
+  end += strspn(end, "-+ #0");
+  *pad = atoi(end);
+  end += strspn(end, "0123456789");
+  if (*end == '.') {
+    end += 1;
+    *pad += atoi(end);
+    end += strspn(end, "0123456789");
+  }
+  *prefix = end - spec;
+  end += strspn(end, "hl");
+  *length = end - spec + 1;
+
+  return (*end != '\0' && strchr("dicuoxXeEfgGsp%", *end) != NULL) ? *end : 0;
+}
+
+
+/* captures the args for format into error, copying strings into the arena
+    since they may not outlive the C library function */
+static void error_capture(SxcContext* context, SxcError* error, int code, const char* format, va_list varg) {
+  SxcErrorArg* arg;
+  const char* string;
+  char* copy;
+  char conversion;
+  int is_long;
+  int is_longlong;
+  int length;
+  int prefix;
+  int pad;
+
+  error->code = code;
+  error->format = format;
+  error->argcount = 0;
+
+  while ((format = strchr(format, '%')) != NULL) {
+    format += 1;
+    conversion = error_spec(format, &length, &prefix, &pad);
+    is_long = SPEC_IS_LONG(format, length, prefix);
+    is_longlong = SPEC_IS_LONGLONG(format, length, prefix);
+
+    if (conversion == 0 || error->argcount == SXC_ERROR_MAX_ARGS) {
+      /* the rest of the format is written literally */
+      break;
+    }
+    format += length;
+    if (conversion == '%') {
+      continue;
+    }
+
+    arg = &(error->args[error->argcount]);
+    error->argcount += 1;
+    arg->conversion = conversion;
+    switch (conversion) {
+      case 'd':
+      case 'i':
+        if (is_longlong) {
+          arg->value.ll = va_arg(varg, SxcInt64);
+        } else {
+          arg->value.i = is_long ? va_arg(varg, long) : va_arg(varg, int);
+        }
+        break;
+      case 'c':
+        arg->value.i = va_arg(varg, int);
+        break;
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X':
+        if (is_longlong) {
+          arg->value.ll = (SxcInt64)va_arg(varg, UInt64);
+        } else {
+          arg->value.u = is_long ? va_arg(varg, unsigned long) : va_arg(varg, unsigned int);
+        }
+        break;
+      case 'p':
+        arg->value.p = va_arg(varg, void*);
+        break;
+      case 's':
+        string = va_arg(varg, const char*);
+        if (string != NULL && (copy = sxc_alloc(context, strlen(string) + 1)) != NULL) {
+          arg->value.s = memcpy(copy, string, strlen(string) + 1);
+        } else {
+          arg->value.s = "(null)";
+        }
+        break;
+      default:
+        arg->value.d = va_arg(varg, double);
+        break;
+    }
+  }
+}
+
+
+/* Writes format to buffer using args (starting from args[*argi]), returning
+    the length written.  If buffer is NULL, returns an upper bound on the
+    length instead. */
+static int error_vformat(const char* format, const SxcErrorArg* args, int argcount, int* argi, char* buffer) {
+  const SxcErrorArg* arg;
+  char spec[32];
+  char* spec_end;
+  char conversion;
+  int is_longlong;
+  int length = 0;
+  int spec_length;
+  int prefix;
+  int pad;
+
+  while (*format != '\0') {
+    conversion = (*format == '%')
+        ? error_spec(format + 1, &spec_length, &prefix, &pad) : 0;
+
+    if (conversion == '%') {
+      /* write a single '%' */
+      format += 1;
+    }
+    if (conversion == 0 || conversion == '%' || *argi >= argcount
+        || prefix + 6 > (int)sizeof(spec)) {
+      if (buffer != NULL) {
+        buffer[length] = *format;
+      }
+      length += 1;
+      format += 1;
+      continue;
+    }
+
+    arg = &(args[*argi]);
+    *argi += 1;
+
+    /* rebuild the spec with the length modifier of the captured arg */
+    is_longlong = SPEC_IS_LONGLONG(format + 1, spec_length, prefix);
+    spec[0] = '%';
+    memcpy(spec + 1, format + 1, prefix);
+    spec_end = spec + 1 + prefix;
+    if (strchr("diuoxX", conversion) != NULL) {
+      strcpy(spec_end, is_longlong ? INT64_MODIFIER : "l");
+      spec_end += strlen(spec_end);
+    }
+    spec_end[0] = conversion;
+    spec_end[1] = '\0';
+    format += spec_length + 1;
+
+    if (buffer == NULL) {
+      length += pad + (conversion == 's' ? (int)strlen(arg->value.s)
+          : (strchr("eEfgG", conversion) != NULL ? 320 : 24));
+    } else {
+      switch (conversion) {
+        case 'd':
+        case 'i':
+          length += is_longlong ? sprintf(buffer + length, spec, arg->value.ll)
+              : sprintf(buffer + length, spec, arg->value.i);
+          break;
+        case 'c':
+          length += sprintf(buffer + length, spec, (int)arg->value.i);
+          break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+          length += is_longlong ? sprintf(buffer + length, spec, (UInt64)arg->value.ll)
+              : sprintf(buffer + length, spec, arg->value.u);
+          break;
+        case 'p':
+          length += sprintf(buffer + length, spec, arg->value.p);
+          break;
+        case 's':
+          length += sprintf(buffer + length, spec, arg->value.s);
+          break;
+        default:
+          length += sprintf(buffer + length, spec, arg->value.d);
+          break;
+      }
+    }
+  }
+
+  return length;
+}
+
+
+/* Formats the message of error into buffer (null terminated) and returns its
+    length.  If buffer is NULL, returns an upper bound on the length instead,
+    so bindings can size the buffer (adding 1 for the null terminator). */
+int sxc_error_format(const SxcError* error, char* buffer) {
+  int argi = 0;
+  int length = 0;
+
+  if (error->code == SXC_ERROR_TYPE) {
+    /* format is the value name, followed by the expected and actual types */
+    length += error_vformat("Expected ", error->args, error->argcount, &argi, buffer);
+    length += error_vformat(error->format, error->args, error->argcount - 2, &argi,
+        buffer == NULL ? NULL : buffer + length);
+    length += error_vformat(" to be %s (or compatible).  Actual value was %s.",
+        error->args, error->argcount, &argi, buffer == NULL ? NULL : buffer + length);
+  } else {
+    length += error_vformat(error->format, error->args, error->argcount, &argi, buffer);
+  }
+
+  if (buffer != NULL) {
+    buffer[length] = '\0';
+  }
+  return length;
+}
+
+
+static void* error_throw(SxcContext* context) {
+  context->has_error = true;
+
+  /* Long jump back to C library's invocation point (unless invoked via
+      sxc_try_nothrow(), in which case the C library checks return values) */
+  if (context->_jmpbuf != NULL) {
+    LONGJMP(*(JMP_BUF*)(context->_jmpbuf), 1);
+  }
+
+  return NULL;
+}
+
+
+/* Raises the out of memory error without allocating anything (unlike
+    sxc_error), since that could fail too */
+static void* out_of_memory(SxcContext* context) {
+  static char message[] = "Error: out of memory";
+
+  if (context->_jmpbuf == NULL && context->has_error) {
+    return NULL;
+  }
+
+  sxc_value_set(&context->return_value, sxc_cchars, message, (int)sizeof(message) - 1);
+  context->error.code = SXC_ERROR_MESSAGE;
+  context->error.format = "%s";
+  context->error.argcount = 1;
+  context->error.args[0].conversion = 's';
+  context->error.args[0].value.s = message;
+  return error_throw(context);
+}
+
+
+/* Raises an error with a numeric code, without formatting its message: the
+    args are captured and, for codes from SXC_ERROR_USER on, the binding
+    formats them only if the script asks for the message (see
+    sxc_error_format).  Supports d, i, c, u, o, x, X, e, E, f, g, G, s, and p
+    conversions with flags, width, precision, and an h, l, or ll length
+    modifier, up to SXC_ERROR_MAX_ARGS args.
+
+    NOTE format must outlive the error (e.g. be a string literal), because
+    bindings may hold onto it after the C library function returns. */
+void* sxc_raise(SxcContext* context, int code, const char* format, ...) {
+  va_list varg;
+
+  if (context->_jmpbuf == NULL && context->has_error) {
+    return NULL;
+  }
+
+  va_start(varg, format);
+  error_capture(context, &(context->error), code, format, varg);
+  va_end(varg);
+
+  sxc_value_set(&context->return_value, sxc_null);
+  return error_throw(context);
+}
 
 
 void* sxc_error(SxcContext* context, const char* message_format, ...) {
@@ -95,22 +929,33 @@ void* sxc_error(SxcContext* context, const char* message_format, ...) {
   int buffer_len;
   int actual_len;
 
+  /* without a jump buffer, the function keeps running after an error, so keep
+      the first error rather than whatever comes after it */
+  if (context->_jmpbuf == NULL && context->has_error) {
+    return NULL;
+  }
+
   /* Step 1: Format error message */
   /* if compiling under the C99 standard, use vsnprintf for safety,
       otherwise, do the best we can by allocating extra buffer space */
   #if __STDC_VERSION__ >= 199901L
     buffer_len = strlen(message_format) * 8;
     buffer = sxc_alloc(context, buffer_len);
+    if (buffer == NULL) {
+      return NULL;
+    }
     va_start(varg, message_format);
-    vsnprintf(buffer, buffer_len, message_format, varg);
+    actual_len = vsnprintf(buffer, buffer_len, message_format, varg);
     va_end(varg);
 
     /* proper vsnprintf implementations return length that should have been
         written (not including null terminator)... */
     if ((actual_len + 1) > buffer_len) {
-      /* TODO sxc_context_free(buffer) */
       buffer_len = actual_len + 1;
-      buffer = sxc_alloc(context, buffer_len);
+      buffer = sxc_realloc(context, buffer, buffer_len);
+      if (buffer == NULL) {
+        return NULL;
+      }
 
       va_start(varg, message_format);
       vsnprintf(buffer, buffer_len, message_format, varg);
@@ -118,9 +963,11 @@ void* sxc_error(SxcContext* context, const char* message_format, ...) {
     } else {
       /* ...but some older vsnprintf implementations return -1 when buffer_len is exceeded... */
       while (actual_len < 0) {
-        /* TODO sxc_context_free(buffer) */
         buffer_len *= 4;
-        buffer = sxc_alloc(context, buffer_len);
+        buffer = sxc_realloc(context, buffer, buffer_len);
+        if (buffer == NULL) {
+          return NULL;
+        }
 
         va_start(varg, message_format);
         actual_len = vsnprintf(buffer, buffer_len, message_format, varg);
@@ -131,6 +978,9 @@ void* sxc_error(SxcContext* context, const char* message_format, ...) {
   #else
     buffer_len = strlen(message_format) * 32;
     buffer = sxc_alloc(context, buffer_len);
+    if (buffer == NULL) {
+      return NULL;
+    }
 
     va_start(varg, message_format);
     actual_len = vsprintf(buffer, message_format, varg);
@@ -139,16 +989,22 @@ void* sxc_error(SxcContext* context, const char* message_format, ...) {
 
   /* Step 2: Save formatted error message */
   sxc_value_set(&context->return_value, sxc_cchars, buffer, actual_len);
-  context->has_error = true;
+  context->error.code = SXC_ERROR_MESSAGE;
+  context->error.format = "%s";
+  context->error.argcount = 1;
+  context->error.args[0].conversion = 's';
+  context->error.args[0].value.s = buffer;
 
   /* Step 3: Long jump back to C library's invocation point */
-  LONGJMP(*(JMP_BUF*)(context->_jmpbuf), 1);
-
-  return NULL;
+  return error_throw(context);
 }
 
 
-void sxc_typeerror(SxcContext* context, char* value_name, SxcDataType expected_type, SxcValue* actual_value) {
+void sxc_typeerror(SxcContext* context, SxcDataType expected_type, SxcValue* actual_value, const char* value_name_format, ...) {
+  va_list varg;
+  SxcError value_name;
+  char* buffer;
+
   /* NOTE we assume the primary use case is to extract values from the scripting
       environment, so expected types are written to inform scripters.  On the
       other hand, if the actual type is a C type (i.e. sxc_cXXXX) it isn't
@@ -172,7 +1028,15 @@ void sxc_typeerror(SxcContext* context, char* value_name, SxcDataType expected_t
       /* sxc_cbools */    "a list of booleans",
       /* sxc_cints */     "a list of ints",
       /* sxc_cdoubles */  "a list of doubles",
-      /* sxc_cstrings */  "a list of strings"
+      /* sxc_cstrings */  "a list of strings",
+      /* sxc_cint64 */    "an int",
+      /* sxc_cint64s */   "a list of ints",
+      /* sxc_cfloats */   "a list of numbers",
+      /* sxc_cint8s */    "a list of ints",
+      /* sxc_cuint8s */   "a list of ints",
+      /* sxc_cint16s */   "a list of ints",
+      /* sxc_cuint16s */  "a list of ints",
+      /* sxc_cstringrefs */ "a list of strings"
     };
   const char* actual_types[] = {
       /* sxc_null */      "null",
@@ -192,28 +1056,62 @@ void sxc_typeerror(SxcContext* context, char* value_name, SxcDataType expected_t
       /* sxc_cbools */    "an array of booleans",
       /* sxc_cints */     "an array of ints",
       /* sxc_cdoubles */  "an array of doubles",
-      /* sxc_cstrings */  "an array of strings"
+      /* sxc_cstrings */  "an array of strings",
+      /* sxc_cint64 */    "a 64-bit int",
+      /* sxc_cint64s */   "an array of 64-bit ints",
+      /* sxc_cfloats */   "an array of floats",
+      /* sxc_cint8s */    "an array of 8-bit ints",
+      /* sxc_cuint8s */   "an array of unsigned 8-bit ints",
+      /* sxc_cint16s */   "an array of 16-bit ints",
+      /* sxc_cuint16s */  "an array of unsigned 16-bit ints",
+      /* sxc_cstringrefs */ "an array of borrowed strings"
     };
 
-  if (expected_type == sxc_null) {
-    sxc_error(context, "Can not extract %s because destination type "
-        "is sxc_null.", value_name);
+  if (context->_jmpbuf == NULL && context->has_error) {
+    return;
   }
 
-  else if (expected_type >= (sizeof(expected_types) / sizeof(expected_types[0]))) {
-    sxc_error(context, "Can not extract %s because destination type "
-        "(%d) is unrecognized.", value_name, expected_type);
+  if (expected_type == sxc_null
+      || expected_type >= (sizeof(expected_types) / sizeof(expected_types[0]))) {
+    /* these are mistakes in the C library, so don't bother formatting lazily */
+    va_start(varg, value_name_format);
+    error_capture(context, &value_name, SXC_ERROR_MESSAGE, value_name_format, varg);
+    va_end(varg);
+    buffer = sxc_alloc(context, sxc_error_format(&value_name, NULL) + 1);
+    if (buffer == NULL) {
+      return;
+    }
+    sxc_error_format(&value_name, buffer);
+
+    if (expected_type == sxc_null) {
+      sxc_error(context, "Can not extract %s because destination type "
+          "is sxc_null.", buffer);
+    } else {
+      sxc_error(context, "Can not extract %s because destination type "
+          "(%d) is unrecognized.", buffer, expected_type);
+    }
   }
 
   else {
-    sxc_error(context, "Expected %s to be %s (or compatible).  Actual value was %s.",
-        value_name,
-        expected_types[expected_type],
+    /* NOTE value_name_format takes at most one arg, so there's room for the
+        expected and actual types */
+    va_start(varg, value_name_format);
+    error_capture(context, &(context->error), SXC_ERROR_TYPE, value_name_format, varg);
+    va_end(varg);
+
+    context->error.args[context->error.argcount].conversion = 's';
+    context->error.args[context->error.argcount].value.s = expected_types[expected_type];
+    context->error.args[context->error.argcount + 1].conversion = 's';
+    context->error.args[context->error.argcount + 1].value.s =
         actual_value->type >= (sizeof(actual_types) / sizeof(actual_types[0]))
           ? "of unknown type"
-          : actual_types[actual_value->type]);
+          : actual_types[actual_value->type];
+    context->error.argcount += 2;
     /* TODO turn value to string (if possible) and truncate (with ellipsis) if
         string is too long */
+
+    sxc_value_set(&context->return_value, sxc_null);
+    error_throw(context);
   }
 }
 
@@ -223,9 +1121,7 @@ int sxc_arg(SxcContext* context, int index, bool is_required, SxcDataType type,
   int retval = SXC_FAILURE;
   SxcValue value;
 
-  const char* value_name_format = "argument %d";
-  char* value_name;
-
+  value.type = sxc_null;
   if (index < context->argcount) {
     value.context = context;
     (context->binding->get_arg)(context, index, &value);
@@ -239,10 +1135,7 @@ int sxc_arg(SxcContext* context, int index, bool is_required, SxcDataType type,
   }
 
   if (is_required && retval != SXC_SUCCESS) {
-    value_name = sxc_alloc(context, sizeof(char) * (strlen(value_name_format) + 20 + 1));
-    sprintf(value_name, value_name_format, index + 1 /* start counting at 1 */);
-
-    sxc_typeerror(context, value_name, type, &value);
+    sxc_typeerror(context, type, &value, "argument %d", index + 1 /* start counting at 1 */);
   }
   return retval;
 }
@@ -251,21 +1144,134 @@ int sxc_arg(SxcContext* context, int index, bool is_required, SxcDataType type,
 void sxc_return(SxcContext* context, SxcDataType type, SXC_DATA_ARG) {
   va_list varg;
 
+  /* don't clobber the error message */
+  if (context->has_error) {
+    return;
+  }
+
   va_start(varg, type);
   sxc_value_setv(&context->return_value, type, varg);
   va_end(varg);
 }
 
 
-void sxc_try(SxcContext* context, void* underlying, SxcContextBinding* binding, int argcount, SxcLibFunc func) {
-  JMP_BUF jmpbuf;
+/* Returns array as a buffer that the scripting environment owns, instead of
+    copying it into a new script map.  An array that has a large chunk to itself
+    (i.e. one from sxc_alloc() bigger than SXC_MEMORY_LARGE_SIZE) is moved
+    rather than copied, so it must not be used after this call.  Bindings
+    without buffers get a script map copy of array right away instead. */
+void sxc_return_buffer(SxcContext* context, SxcDataType type, void* array, int length) {
+  SxcMemoryChunk** large_link;
+  SxcMemoryChunk* chunk = NULL;
+  SxcBuffer buffer;
+  int elementsize = sxc_value_elementsize(type);
+  int size;
+
+  /* don't clobber the error message */
+  if (context->has_error) {
+    return;
+  }
+
+  if (elementsize == 0 || length < 0) {
+    sxc_error(context, "Error: invalid buffer (type %d, length %d)", (int)type, length);
+    return;
+  }
+  /* NOTE leave room for the chunk's tag and alignment padding too */
+  if (length > (INT_MAX - (int)sizeof(SxcMemoryTag) - SXC_MEMORY_ARRAY_ALIGN) / elementsize) {
+    sxc_error(context, "Error: buffer too large (type %d, length %d)", (int)type, length);
+    return;
+  }
+  size = elementsize * length;
+  if (context->binding->buffer_new == NULL) {
+    sxc_return(context, type, array, length);
+    sxc_value_snormalize(&context->return_value);
+    return;
+  }
+
+  /* the buffer gets the array's chunk when it's the only thing in it,
+      otherwise a large chunk of its own, with a copy of the array */
+  large_link = size == 0 ? NULL : find_large_chunk(context, array);
+  if (large_link != NULL && IS_CHUNK_TAIL(*large_link, array) && TAG_OF(array)->start == 0) {
+    chunk = *large_link;
+  } else {
+    chunk = new_chunk(context, size + sizeof(SxcMemoryTag) + SXC_MEMORY_ARRAY_ALIGN - 1);
+    if (chunk == NULL) {
+      return;
+    }
+    chunk->serial = ++(context->_largeserial);
+    chunk->next_chunk = context->_largechunks;
+    context->_largechunks = chunk;
+    if (size > 0) {
+      array = memcpy(chunk_alloc(chunk, size, SXC_MEMORY_ARRAY_ALIGN), array, size);
+    } else {
+      array = chunk_alloc(chunk, 0, SXC_MEMORY_ARRAY_ALIGN);
+    }
+  }
+
+  buffer.type = type;
+  buffer.array = array;
+  buffer.length = length;
+  buffer._chunk = chunk;
+  (context->binding->buffer_new)(&buffer, &context->return_value);
+
+  /* NOTE the chunk stays with the context until buffer_new() returns, since a
+      binding error (e.g. the script running out of memory) may escape it */
+  large_link = &(context->_largechunks);
+  while (*large_link != chunk) {
+    large_link = &((*large_link)->next_chunk);
+  }
+  *large_link = chunk->next_chunk;
+  chunk->next_chunk = NULL;
+}
+
+
+/* NOTE may be called from any thread, so the chunk bypasses the pool */
+void sxc_buffer_free(SxcBuffer* buffer) {
+  if (buffer->_chunk != NULL) {
+    chunk_free((SxcMemoryChunk*)buffer->_chunk);
+  }
+  buffer->_chunk = NULL;
+  buffer->array = NULL;
+  buffer->length = 0;
+}
+
 
+static void context_init(SxcContext* context, void* underlying, SxcContextBinding* binding, int argcount, SxcLibFunc func) {
   context->underlying = underlying;
   context->binding = binding;
   context->argcount = argcount;
   context->return_value = (SxcValue){context, sxc_null, {0}};
+  context->has_error = false;
+  context->error.code = SXC_ERROR_MESSAGE;
+  context->error.argcount = 0;
+  context->_jmpbuf = NULL;
+  context->_state = NULL;
+  context->_firstchunk = (SxcMemoryChunk){SXC_MEMORY_CHUNK_INIT_SIZE, NULL, NULL, NULL, 0, 0, 0};
+  context->_curchunk = &(context->_firstchunk);
+  context->_largechunks = NULL;
+  context->_largeserial = 0;
+  context->_func = func;
+  context->_usage = 0;
+  context->_peakusage = 0;
+  context->_chunkhint = 0;
+}
+
+
+void sxc_try(SxcContext* context, void* underlying, SxcContextBinding* binding, int argcount, SxcLibFunc func) {
+  JMP_BUF jmpbuf;
+  SxcLibFuncStats* stats;
+
+  context_init(context, underlying, binding, argcount, func);
   context->_jmpbuf = &jmpbuf;
-  context->_firstchunk = (SxcMemoryChunk){SXC_MEMORY_CHUNK_INIT_SIZE, NULL, 0, 0};
+
+  /* pre-size the first overflow chunk, as long as it stays poolable (NOTE the
+      inline chunk's share of the usage is kept as headroom for the space
+      stranded at its end) */
+  if ((stats = find_stats(func, false)) != NULL) {
+    context->_chunkhint = stats->typical_usage;
+    context->_chunkhint = context->_chunkhint > poollimits.max_chunk_size
+        ? poollimits.max_chunk_size : context->_chunkhint;
+  }
 
   if (!(context->has_error = SETJMP(jmpbuf))) {
     (func)(context);
@@ -275,11 +1281,25 @@ void sxc_try(SxcContext* context, void* underlying, SxcContextBinding* binding,
 }
 
 
+/* For functions registered as is_nothrow: skips the jump buffer (and chunk
+    pre-sizing), so errors raised by sxc_error() and friends are only recorded
+    in the context, and the function is expected to return when it sees a
+    failure status. */
+void sxc_try_nothrow(SxcContext* context, void* underlying, SxcContextBinding* binding, int argcount, SxcLibFunc func) {
+  context_init(context, underlying, binding, argcount, func);
+
+  (func)(context);
+
+  sxc_value_snormalize(&context->return_value);
+}
+
+
 void sxc_finally(SxcContext* context) {
-  SxcMemoryChunk* walker = context->_firstchunk.next_chunk;
-  while (walker != NULL) {
-    context->_firstchunk.next_chunk = walker->next_chunk;
-    free(walker);
-    walker = context->_firstchunk.next_chunk;
-  }
+  record_stats(context->_func, context->_peakusage);
+
+  free_chunks(context->_state, context->_firstchunk.next_chunk);
+  free_chunks(context->_state, context->_largechunks);
+  context->_firstchunk.next_chunk = NULL;
+  context->_largechunks = NULL;
+  context->_curchunk = &(context->_firstchunk);
 }
@@ -1,7 +1,7 @@
 #include <stdarg.h>
 #include "sxc.h"
 
-void sxc_typeerror(SxcContext* context, char* value_name, SxcDataType expected_type, SxcValue* actual_value);
+void sxc_typeerror(SxcContext* context, SxcDataType expected_type, SxcValue* actual_value, const char* value_name_format, ...);
 int sxc_value_getv(SxcValue* value, SxcDataType type, va_list varg);
 void sxc_value_setv(SxcValue* value, SxcDataType type, va_list varg);
 void sxc_value_snormalize(SxcValue* value);
@@ -9,34 +9,34 @@ void sxc_value_cnormalize(SxcValue* value);
 
 
 #include <stdio.h>
-/* TODO this function signature still feels off... how can it be more intuitive? */
-void sxc_func_invoke(SxcFunc* func, int argcount, SxcDataType return_type, SXC_DATA_DEST_ARGS) {
-  va_list varg;
-
+/* Puts the args (following the dest part of varg) into SxcValues and invokes
+    func, returning the binding's status.  If the script function raised an
+    error, return_value is the error (as a string, if the binding can manage
+    it). */
+static int func_call(SxcFunc* func, int argcount, SxcDataType return_type, SxcValue* return_value, va_list varg) {
   const int default_argcount = 32;
   SxcValue values[default_argcount];
   SxcValue* arg_values = values;
   SxcValue* valueptrs[default_argcount];
   SxcValue** arg_valueptrs = valueptrs;
-  SxcValue return_value;
 
   int i;
   SxcDataType type;
-  int has_return_value;
 
-printf("in sxc_function_invoke\n");
+  return_value->context = func->context;
+  return_value->type = sxc_null;
 
   /* allocate more room for args if necessary (unlikely) */
   if (argcount > default_argcount) {
     arg_valueptrs = sxc_alloc(func->context, argcount * (sizeof(SxcValue*) + sizeof(SxcValue)));
+    if (arg_valueptrs == NULL) {
+      return SXC_FAILURE;
+    }
     arg_values = (SxcValue*)(arg_valueptrs + argcount);
   }
 
   /* skip over dest part of varargs (we come back to it later) */
-  return_value.context = func->context;
-  return_value.type = sxc_null;
-  va_start(varg, return_type);
-  sxc_value_getv(&return_value, return_type, varg);
+  sxc_value_getv(return_value, return_type, varg);
 printf("done skipping dest\n");
 
   /* point arg_valueptrs to arg_values, and put rest of varargs into them */
@@ -50,25 +50,91 @@ printf("done setting arg %d\n", i);
     sxc_value_snormalize(arg_valueptrs[i]);
 printf("done interning arg %d\n", i);
   }
-  va_end(varg);
+
+  /* a failed conversion leaves the error set in nothrow mode (see
+      sxc_try_nothrow) */
+  if (func->context->has_error) {
+    return SXC_FAILURE;
+  }
 
   /* invoke function */
-  (func->binding->invoke)(func->underlying, arg_valueptrs, argcount, &return_value);
-printf("done invoking func\n");
+  return (func->binding->invoke)(func->underlying, arg_valueptrs, argcount, return_value);
+}
+
+
+/* extracts return_value to the dest part of varg */
+static void func_return(SxcFunc* func, SxcDataType return_type, SxcValue* return_value, va_list varg) {
+  int has_return_value;
 
-  /* extract return_value to dest */
   if (return_type != sxc_null) {
     if (return_type == sxc_value) {
-      sxc_value_cnormalize(&return_value);
+      sxc_value_cnormalize(return_value);
     }
 
-    va_start(varg, return_type);
-    has_return_value = sxc_value_getv(&return_value, return_type, varg);
+    has_return_value = sxc_value_getv(return_value, return_type, varg);
 printf("done extracting return_value\n");
-    va_end(varg);
 
     if (has_return_value != SXC_SUCCESS) {
-      sxc_typeerror(func->context, "return value", return_type, &return_value);
+      sxc_typeerror(func->context, return_type, return_value, "return value");
     }
   }
 }
+
+
+/* TODO this function signature still feels off... how can it be more intuitive? */
+void sxc_func_invoke(SxcFunc* func, int argcount, SxcDataType return_type, SXC_DATA_DEST_ARGS) {
+  va_list varg;
+  SxcValue return_value;
+  int status;
+  char* message;
+
+printf("in sxc_function_invoke\n");
+
+  va_start(varg, return_type);
+  status = func_call(func, argcount, return_type, &return_value, varg);
+  va_end(varg);
+printf("done invoking func\n");
+
+  /* re-raise script errors from here, so the context is still cleaned up
+      normally (see sxc_finally) */
+  if (status != SXC_SUCCESS) {
+    if (sxc_value_get(&return_value, sxc_cstring, &message) == SXC_SUCCESS) {
+      sxc_error(func->context, "%s", message);
+    } else {
+      sxc_error(func->context, "Script function raised an error.");
+    }
+    return;
+  }
+
+  va_start(varg, return_type);
+  func_return(func, return_type, &return_value, varg);
+  va_end(varg);
+}
+
+
+/* Same as sxc_func_invoke(), except that an error raised by the script
+    function is caught: SXC_FAILURE is returned and, if return_error isn't
+    NULL, the error is put in it (otherwise SXC_SUCCESS is returned).  NOTE
+    the dest is left untouched on failure, and a return value of the wrong
+    type is still raised as an error. */
+int sxc_func_pinvoke(SxcFunc* func, SxcValue* return_error, int argcount, SxcDataType return_type, SXC_DATA_DEST_ARGS) {
+  va_list varg;
+  SxcValue return_value;
+  int status;
+
+  va_start(varg, return_type);
+  status = func_call(func, argcount, return_type, &return_value, varg);
+  va_end(varg);
+
+  if (status != SXC_SUCCESS) {
+    if (return_error != NULL) {
+      *return_error = return_value;
+    }
+    return SXC_FAILURE;
+  }
+
+  va_start(varg, return_type);
+  func_return(func, return_type, &return_value, varg);
+  va_end(varg);
+  return SXC_SUCCESS;
+}
@@ -114,18 +114,25 @@ static char* fix_lib_name(SxcContext* context, const char* lib_name, int lib_nam
 
 
 
+/* libraries are tracked per SxcState, since each scripting environment
+    instance needs its own call to the register function */
 typedef struct _LoadedLib {
   char* name;
   SxcLibFunc* register_func;
   struct _LoadedLib* next;
 } LoadedLib;
 
-LoadedLib* loaded_libs;
+#define LOADED_LIB_SIZE(name_len) (sizeof(LoadedLib) + (name_len) + 1)
+
+SxcState* sxc_context_state(SxcContext* context);
+
 
 void sxc_load(SxcContext* context) {
+  SxcState* state = sxc_context_state(context);
   char* lib_name;
   int lib_name_len;
   LoadedLib* lib;
+  SxcLibFunc* register_func;
 
 printf("in sxc_load, lib_name:%p lib_name_len:%p\n", &lib_name, &lib_name_len);
 
@@ -139,31 +146,49 @@ printf("done extract lib_name from args, name:%s, len:%d\n", lib_name, lib_name_
       can be referred to by multiple names.  However, each platform's loader
       does track the loaded binaries and doesn't try to load the same binary
       more than once. */
-  /* TODO change this behavior! load only once */
-  lib = loaded_libs;
-  while (lib != NULL && strncmp(lib->name, lib_name, lib_name_len) != 0) ;
+  lib = state->_loadedlibs;
+  while (lib != NULL
+      && (strncmp(lib->name, lib_name, lib_name_len) != 0 || lib->name[lib_name_len] != '\0')) {
+    lib = lib->next;
+  }
 
 printf("done find lib if it's already been loaded\n");
 
   /* if library is new, load and invoke register function */
   if (lib == NULL) {
+    register_func = get_register_func(context, lib_name, lib_name_len);
+printf("get new lib register_func\n");
+
     /* space for name is allocated immediately following the struct */
-    lib = malloc(sizeof(LoadedLib) + lib_name_len + 1);
-printf("done alloc new lib struct, name_len: %d\n", lib_name_len);
+    lib = (state->allocf)(state->allocud, NULL, 0, LOADED_LIB_SIZE(lib_name_len));
+    if (lib == NULL) {
+      sxc_error(context, "Error: out of memory");
+    }
     lib->name = (char*)(lib + 1);
     memcpy(lib->name, lib_name, lib_name_len);
-printf("done set new lib name\n");
     lib->name[lib_name_len] = '\0';
-printf("done terminate new lib name\n");
-
-    lib->register_func = get_register_func(context, lib_name, lib_name_len);
-printf("get new lib register_func\n");
+    lib->register_func = register_func;
 
     /* insert into list */
-    lib->next = loaded_libs;
-    loaded_libs = lib;
+    lib->next = state->_loadedlibs;
+    state->_loadedlibs = lib;
 
     (lib->register_func)(context);
 printf("done register_func()\n");
   }
 }
+
+
+void sxc_load_close(SxcState* state) {
+  LoadedLib* lib = state->_loadedlibs;
+  LoadedLib* next;
+
+  /* NOTE the libraries themselves stay loaded, since other states may be
+      using them */
+  while (lib != NULL) {
+    next = lib->next;
+    (state->allocf)(state->allocud, lib, LOADED_LIB_SIZE(strlen(lib->name)), 0);
+    lib = next;
+  }
+  state->_loadedlibs = NULL;
+}
@@ -3,20 +3,22 @@
 #include <string.h>
 #include "sxc.h"
 
-void sxc_typeerror(SxcContext* context, char* value_name, SxcDataType expected_type, SxcValue* actual_value);
+void sxc_typeerror(SxcContext* context, SxcDataType expected_type, SxcValue* actual_value, const char* value_name_format, ...);
 int sxc_value_getv(SxcValue* value, SxcDataType type, va_list varg);
 void sxc_value_setv(SxcValue* value, SxcDataType type, va_list varg);
 void sxc_value_snormalize(SxcValue* value);
 void sxc_value_cnormalize(SxcValue* value);
+int sxc_value_elementsize(SxcDataType type);
+int sxc_value_toelement(SxcValue* value, SxcDataType type, void* element);
 
 
 
-SxcMap* sxc_map_new(SxcContext* context, void* map_type) {
+SxcMap* sxc_map_new(SxcContext* context, void* map_type, int array_size, int hash_size) {
   SxcValue value;
   SxcMap* map;
 
   value.context = context;
-  (context->binding->map_new)(map_type, &value);
+  (context->binding->map_new)(map_type, array_size, hash_size, &value);
   sxc_value_get(&value, sxc_map, &map);
   return map;
 }
@@ -39,9 +41,6 @@ int sxc_map_intget(SxcMap* map, int key, bool is_required, SxcDataType type, SXC
   int retval;
   SxcValue value;
 
-  const char* value_name_format = "element %d";
-  char* value_name;
-
   value.context = map->context;
   (map->binding->intget)(map->underlying, key, &value);
   if (type == sxc_value) {
@@ -53,10 +52,7 @@ int sxc_map_intget(SxcMap* map, int key, bool is_required, SxcDataType type, SXC
   va_end(varg);
 
   if (is_required && retval != SXC_SUCCESS) {
-    value_name = sxc_alloc(map->context, sizeof(char) * (strlen(value_name_format) + 20 + 1));
-    sprintf(value_name, value_name_format, key);
-
-    sxc_typeerror(map->context, value_name, type, &value);
+    sxc_typeerror(map->context, type, &value, "element %d", key);
   }
   return retval;
 }
@@ -71,8 +67,12 @@ void sxc_map_intset(SxcMap* map, int key, SxcDataType type, SXC_DATA_ARG) {
   sxc_value_setv(&value, type, varg);
   va_end(varg);
 
+  /* NOTE in nothrow mode, a failed conversion leaves the error set rather
+      than jumping, and there's nothing to store */
   sxc_value_snormalize(&value);
-  (map->binding->intset)(map->underlying, key, &value);
+  if (!map->context->has_error) {
+    (map->binding->intset)(map->underlying, key, &value);
+  }
 }
 
 
@@ -81,9 +81,6 @@ int sxc_map_strget(SxcMap* map, const char* key, bool is_required, SxcDataType t
   int retval;
   SxcValue value;
 
-  const char* value_name_format = "element \"%s\"";
-  char* value_name;
-
   value.context = map->context;
   (map->binding->strget)(map->underlying, key, &value);
   if (type == sxc_value) {
@@ -95,10 +92,7 @@ int sxc_map_strget(SxcMap* map, const char* key, bool is_required, SxcDataType t
   va_end(varg);
 
   if (is_required && retval != SXC_SUCCESS) {
-    value_name = sxc_alloc(map->context, sizeof(char) * (strlen(value_name_format) + strlen(key) + 1));
-    sprintf(value_name, value_name_format, key);
-
-    sxc_typeerror(map->context, value_name, type, &value);
+    sxc_typeerror(map->context, type, &value, "element \"%s\"", key);
   }
   return retval;
 }
@@ -113,8 +107,12 @@ void sxc_map_strset(SxcMap* map, const char* key, SxcDataType type, SXC_DATA_ARG
   sxc_value_setv(&value, type, varg);
   va_end(varg);
 
+  /* NOTE in nothrow mode, a failed conversion leaves the error set rather
+      than jumping, and there's nothing to store */
   sxc_value_snormalize(&value);
-  (map->binding->strset)(map->underlying, key, &value);
+  if (!map->context->has_error) {
+    (map->binding->strset)(map->underlying, key, &value);
+  }
 }
 
 
@@ -150,10 +148,15 @@ int sxc_map_length(SxcMap* map) {
   SxcValue val;
   int key_count = 0;
   int key_max = -1;
+  SxcBuffer* buffer;
 
   if (map->binding->length != NULL) {
     return (map->binding->length)(map->underlying);
   }
+  if (map->binding->getbuffer != NULL
+      && (buffer = (map->binding->getbuffer)(map->underlying, map->context)) != NULL) {
+    return buffer->length;
+  }
 
   /* For bindings that don't provide a length() function, a length is computed
       based on the max integer key of the map.  However, if the map contains any
@@ -198,3 +201,201 @@ void* sxc_map_iter(SxcMap* map, void* state, SxcValue* return_key, SxcValue* ret
 
   return state;
 }
+
+
+
+/* Sets up view to read map's elements as elements of the given array type
+    (e.g. sxc_cdoubles), converted as if the whole map were.  With a
+    block_size, reads fetch that many neighbouring elements at a time (through
+    the binding's intgetrange(), if it has one) and keep the last block, which
+    suits scanning a part of the map.  Without, each read fetches one element,
+    which suits sampling it.  A buffer of the same type is read in place. */
+int sxc_view_init(SxcView* view, SxcMap* map, SxcDataType type, int block_size) {
+  SxcBuffer* buffer = map->binding->getbuffer == NULL ? NULL
+      : (map->binding->getbuffer)(map->underlying, map->context);
+
+  view->map = map;
+  view->type = type;
+  view->_length = -2;
+  view->_elementsize = sxc_value_elementsize(type);
+  view->_blocksize = block_size < 0 ? 0 : block_size;
+  view->_blockstart = 0;
+  view->_blockcount = 0;
+  view->_block = NULL;
+
+  if (view->_elementsize == 0) {
+    sxc_error(map->context, "Error: invalid view (type %d)", (int)type);
+    return SXC_FAILURE;
+  }
+
+  /* a buffer is one big block that's always cached */
+  if (buffer != NULL && buffer->type == type) {
+    view->_length = buffer->length;
+    view->_blocksize = 0;
+    view->_blockcount = buffer->length;
+    view->_block = buffer->array;
+  } else if (view->_blocksize > 0) {
+    view->_block = sxc_alloc_aligned(map->context,
+        view->_blocksize * view->_elementsize, SXC_MEMORY_ARRAY_ALIGN);
+    if (view->_block == NULL) {
+      view->_blocksize = 0;
+      return SXC_FAILURE;
+    }
+  }
+  return SXC_SUCCESS;
+}
+
+
+/* whether the map has an element at index */
+static int view_has(SxcView* view, int index) {
+  SxcValue value;
+
+  value.context = view->map->context;
+  (view->map->binding->intget)(view->map->underlying, index, &value);
+  return value.type != sxc_null;
+}
+
+
+/* Returns how many of the count elements starting at start exist, assuming
+    the map is a list (so any missing element is followed only by missing
+    ones), and records the view's length if that shows where the list ends.
+    NOTE without the binding's listlength(), this probes the last element,
+    then binary searches for the first missing one only if the block runs
+    past the end. */
+static int view_count(SxcView* view, int start, int count) {
+  SxcMap* map = view->map;
+  int low = 0;
+  int high = count - 1;
+  int mid;
+
+  if (map->binding->listlength != NULL) {
+    high = (map->binding->listlength)(map->underlying, map->context);
+    if (view->_length == -2) {
+      view->_length = high;
+    }
+    return start >= high ? 0 : high - start < count ? high - start : count;
+  }
+
+  if (count == 0 || view_has(view, start + high)) {
+    return count;
+  }
+
+  /* elements before start + low exist, and the one at start + high doesn't */
+  while (low < high) {
+    mid = low + (high - low) / 2;
+    if (view_has(view, start + mid)) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  /* a block that starts past the end only shows that the list ends sooner
+      (and a negative length, i.e. not a list, is kept) */
+  if ((low > 0 || start == 0) && view->_length == -2) {
+    view->_length = start + low;
+  }
+  return low;
+}
+
+
+/* Fetches count elements starting at start into block (0 for those that can't
+    be converted), and returns how many were fetched, which is fewer than count
+    if the list ends in the block (see view_count). */
+static int view_fetch(SxcView* view, int start, int count, char* block) {
+  SxcMap* map = view->map;
+  SxcValue value;
+  int i;
+
+  /* intgetrange() doesn't tell missing elements from zeros, so the end of
+      the list has to be found first */
+  if (view->_length < 0) {
+    count = view_count(view, start, count);
+  }
+
+  if (count == 0 || (map->binding->intgetrange != NULL
+      && (map->binding->intgetrange)(map->underlying, start, count, view->type, block, map->context))) {
+    return count;
+  }
+
+  value.context = map->context;
+  for (i = 0; i < count; i += 1) {
+    (map->binding->intget)(map->underlying, start + i, &value);
+    if (!sxc_value_toelement(&value, view->type, block + i * view->_elementsize)) {
+      memset(block + i * view->_elementsize, 0, view->_elementsize);
+    }
+  }
+  return count;
+}
+
+
+/* Sets return_element (which points to an element of the view's type, e.g. a
+    double) to the element at index.  Returns SXC_FAILURE, with the element set
+    to 0, if index is out of range (as far as is known, see sxc_view_length) or
+    the element can't be converted.  NOTE elements that are fetched as part of
+    a block, or through the binding's intgetrange(), read as 0 if they can't be
+    converted, but fetching finds the end of the list, so reads at or beyond it
+    fail either way. */
+int sxc_view_get(SxcView* view, int index, void* return_element) {
+  SxcMap* map = view->map;
+  SxcValue value;
+  int count;
+
+  if (index < 0 || (view->_length >= 0 && index >= view->_length)) {
+    memset(return_element, 0, view->_elementsize);
+    return SXC_FAILURE;
+  }
+
+  /* fill the cache with the block holding index, if it isn't there already */
+  if (view->_blocksize > 0
+      && (index < view->_blockstart || index >= view->_blockstart + view->_blockcount)) {
+    view->_blockstart = index - index % view->_blocksize;
+    count = view->_blocksize;
+    if (view->_length >= 0 && view->_blockstart + count > view->_length) {
+      count = view->_length - view->_blockstart;
+    }
+    view->_blockcount = view_fetch(view, view->_blockstart, count, view->_block);
+  }
+
+  if (index >= view->_blockstart && index < view->_blockstart + view->_blockcount) {
+    memcpy(return_element, view->_block + (index - view->_blockstart) * view->_elementsize,
+        view->_elementsize);
+    return SXC_SUCCESS;
+  }
+
+  /* a block that stops short of index ended at the end of the list */
+  if (view->_blocksize > 0) {
+    memset(return_element, 0, view->_elementsize);
+    return SXC_FAILURE;
+  }
+
+  /* otherwise fetch just the one element, through intgetrange() if the binding
+      has it (e.g. the Lua binding's intget() leaves elements on the stack),
+      and the end of the list is known or cheap to find (see view_count) */
+  if (map->binding->intgetrange != NULL
+      && (view->_length >= 0 || map->binding->listlength != NULL)) {
+    if (view_fetch(view, index, 1, return_element) == 1) {
+      return SXC_SUCCESS;
+    }
+    memset(return_element, 0, view->_elementsize);
+    return SXC_FAILURE;
+  }
+
+  value.context = map->context;
+  (map->binding->intget)(map->underlying, index, &value);
+  if (!sxc_value_toelement(&value, view->type, return_element)) {
+    memset(return_element, 0, view->_elementsize);
+    return SXC_FAILURE;
+  }
+  return SXC_SUCCESS;
+}
+
+
+/* NOTE this is computed on first use, since it can cost as much as reading
+    every element (see sxc_map_length) */
+int sxc_view_length(SxcView* view) {
+  if (view->_length == -2) {
+    view->_length = sxc_map_length(view->map);
+  }
+  return view->_length;
+}
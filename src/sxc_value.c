@@ -1,9 +1,27 @@
 #include <math.h>
+#include <limits.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include "sxc.h"
 
+int sxc_number_todouble(const char* cchars, int length, double* cdouble);
+int sxc_number_toint(const char* cchars, int length, int* cint);
+int sxc_number_fromdouble(double cdouble, char* buffer);
+int sxc_number_fromint(int cint, char* buffer);
+int sxc_number_toint64(const char* cchars, int length, SxcInt64* cint64);
+int sxc_number_fromint64(SxcInt64 cint64, char* buffer);
+const char* sxc_number_smallint(int cint, int* length);
+void sxc_vector_intstobools(const int* src, bool* dest, int length);
+void sxc_vector_doublestobools(const double* src, bool* dest, int length);
+void sxc_vector_boolstoints(const bool* src, int* dest, int length);
+void sxc_vector_boolstodoubles(const bool* src, double* dest, int length);
+void sxc_vector_intstodoubles(const int* src, double* dest, int length);
+void sxc_vector_doublestoints(const double* src, int* dest, int length);
+
+/* max chars written by sxc_number_fromdouble() */
+#define SXC_NUMBER_DOUBLE_MAX_CHARS (25)
+
 #ifndef isnan
   #define isnan(X) ((X) != (X))
 #endif
@@ -13,8 +31,43 @@
 #endif
 
 
-/* Convenience typedef for use with macros */
+/* Convenience typedefs for use with macros */
 typedef char* string;
+typedef SxcInt64 int64;
+typedef signed char int8;
+typedef unsigned char uint8;
+typedef short int16;
+typedef unsigned short uint16;
+
+/* whether a 64-bit int (or a double) fits in an int */
+#define FITS_INT(X) ((X) >= INT_MIN && (X) <= INT_MAX)
+
+/* clamps X to [MIN, MAX] for the narrow array types (NaN becomes 0) */
+#define SATURATE(X, MIN, MAX) \
+  ((X) > (MAX) ? (MAX) : (X) >= (MIN) ? (X) : (X) < (MIN) ? (MIN) : 0)
+
+/* truncates double X to an int, clamped to [INT_MIN, INT_MAX] (NaN becomes 0)
+    NOTE X is compared against bounds that are exact as doubles, so it's only
+    cast when the result is in range (see TO_INT in sxc_vector.c) */
+#define DOUBLE_TO_INT(X) \
+  ((X) >= (double)INT_MAX + 1.0 ? INT_MAX : (X) > (double)INT_MIN - 1.0 ? (int)(X) \
+    : (X) <= (double)INT_MIN - 1.0 ? INT_MIN : 0)
+
+/* the same for a 64-bit int (NOTE -2^63 and 2^63 are exact as doubles) */
+#define INT64_MAX_VALUE (((SxcInt64)1 << 62) - 1 + ((SxcInt64)1 << 62))
+#define DOUBLE_TO_INT64(X) \
+  ((X) >= 9223372036854775808.0 ? INT64_MAX_VALUE \
+    : (X) >= -9223372036854775808.0 ? (SxcInt64)(X) \
+    : (X) < -9223372036854775808.0 ? -INT64_MAX_VALUE - 1 : 0)
+
+/* allocates SIZE bytes into PTR, or fails the conversion (NOTE sxc_alloc()
+    only returns NULL when out of memory in a nothrow function, which has
+    already recorded the error, or when SIZE is 0) */
+#define ALLOC_OR_FAIL(PTR, CONTEXT, SIZE, ALIGN)                          \
+  if (((PTR) = sxc_alloc_aligned((CONTEXT), (SIZE), (ALIGN))) == NULL     \
+      && (SIZE) > 0) {                                                    \
+    return SXC_FAILURE;                                                   \
+  }
 
 
 
@@ -26,7 +79,7 @@ static int cchars_to_string(SxcContext* context, char* cchars, int length, SxcSt
   tmp_value.context = context;
   (context->binding->to_sstring)(cchars, length, &tmp_value);
 
-  *string = (SxcString*)sxc_alloc(context, sizeof(SxcString));
+  ALLOC_OR_FAIL(*string, context, sizeof(SxcString), SXC_MEMORY_ALIGN)
   (*string)->underlying = tmp_value.data.sstring.underlying;
   (*string)->binding = tmp_value.data.sstring.binding;
   (*string)->context = context;
@@ -52,23 +105,35 @@ static int cchars_to_cstring(SxcContext* context, char* cchars, int length, int
       at the end of the array is actually data rather than a sentinel; but
       consumer code processing it as a cstring wouldn't know the difference
       anyway, so we just check for a null byte at the end */
-  if (is_null_terminated || cchars[length - 1] == '\0') {
+  if (is_null_terminated || (length > 0 && cchars[length - 1] == '\0')) {
     *cstring = cchars;
   } else {
-    *cstring = sxc_alloc(context, length + 1);
+    ALLOC_OR_FAIL(*cstring, context, length + 1, SXC_MEMORY_ALIGN)
     memcpy(*cstring, cchars, length);
-    *cstring[length] = '\0';
+    (*cstring)[length] = '\0';
   }
   return SXC_SUCCESS;
 }
 
 static int cchars_to_cdouble(char* cchars, int length, int is_null_terminated, double* cdouble) {
-  char decimal_format[32] = "%lf";
-  /* create scanf format string that won't read past end of cchars, if necessary */
-  if (!is_null_terminated) {
-    sprintf(decimal_format, "%%%dlf", length);
+  if (is_null_terminated && length < 0) {
+    length = strlen(cchars);
+  }
+  return sxc_number_todouble(cchars, length, cdouble);
+}
+
+static int cchars_to_cint(char* cchars, int length, int is_null_terminated, int* cint) {
+  if (is_null_terminated && length < 0) {
+    length = strlen(cchars);
+  }
+  return sxc_number_toint(cchars, length, cint);
+}
+
+static int cchars_to_cint64(char* cchars, int length, int is_null_terminated, SxcInt64* cint64) {
+  if (is_null_terminated && length < 0) {
+    length = strlen(cchars);
   }
-  return sscanf(cchars, decimal_format, cdouble) == 1 ? SXC_SUCCESS : SXC_FAILURE;
+  return sxc_number_toint64(cchars, length, cint64);
 }
 
 static int cbool_to_cchars(bool cbool, char** cchars, int* length) {
@@ -83,14 +148,61 @@ static int cbool_to_cchars(bool cbool, char** cchars, int* length) {
 }
 
 static int cint_to_cchars(SxcContext* context, int cint, char** cchars, int* length) {
+  /* small ints are preformatted */
+  if ((*cchars = (char*)sxc_number_smallint(cint, length)) != NULL) {
+    return SXC_SUCCESS;
+  }
+
   /* format the number
    *    NOTE: max digits in a 32-bit signed int is 10 (not including sign)
    *    NOTE: max digits in a 64-bit signed int is 19 (not including sign) */
-  *cchars = sxc_alloc(context, (sizeof(int) <= 4 ? 11 : 20) + 1);
-  *length = sprintf(*cchars, "%d", cint);
+  ALLOC_OR_FAIL(*cchars, context, (sizeof(int) <= 4 ? 11 : 20) + 1, SXC_MEMORY_ALIGN)
+  *length = sxc_number_fromint(cint, *cchars);
+  (*cchars)[*length] = '\0';
+  return SXC_SUCCESS;
+}
+
+static int cint_to_sstring(SxcContext* context, int cint, void** sstring, SxcStringBinding** sstring_binding) {
+  SxcValue tmp_sstring;
+  char* cchars;
+  int length;
+
+  /* use the binding's cached script string, if it has one */
+  tmp_sstring.context = context;
+  if (context->binding->int_to_sstring != NULL
+      && (context->binding->int_to_sstring)(cint, &tmp_sstring) == SXC_SUCCESS) {
+    *sstring = tmp_sstring.data.sstring.underlying;
+    *sstring_binding = tmp_sstring.data.sstring.binding;
+    return SXC_SUCCESS;
+  }
+
+  return cint_to_cchars(context, cint, &cchars, &length)
+      && cchars_to_sstring(context, cchars, length, sstring, sstring_binding);
+}
+
+static int cint64_to_cchars(SxcContext* context, SxcInt64 cint64, char** cchars, int* length) {
+  if (FITS_INT(cint64)) {
+    return cint_to_cchars(context, (int)cint64, cchars, length);
+  }
+
+  /* NOTE: max digits in a 64-bit signed int is 19 (not including sign) */
+  ALLOC_OR_FAIL(*cchars, context, 20 + 1, SXC_MEMORY_ALIGN)
+  *length = sxc_number_fromint64(cint64, *cchars);
+  (*cchars)[*length] = '\0';
   return SXC_SUCCESS;
 }
 
+static int cint64_to_sstring(SxcContext* context, SxcInt64 cint64, void** sstring, SxcStringBinding** sstring_binding) {
+  char* cchars;
+  int length;
+
+  if (FITS_INT(cint64)) {
+    return cint_to_sstring(context, (int)cint64, sstring, sstring_binding);
+  }
+  return cint64_to_cchars(context, cint64, &cchars, &length)
+      && cchars_to_sstring(context, cchars, length, sstring, sstring_binding);
+}
+
 static int cdouble_to_cchars(SxcContext* context, double cdouble, char** cchars, int* length) {
   if (isnan(cdouble)) {
     *cchars = "nan";
@@ -102,21 +214,10 @@ static int cdouble_to_cchars(SxcContext* context, double cdouble, char** cchars,
     *cchars = "inf";
     *length = 3;
   } else {
-    /* format the number into no more than 20 characters (max digits in a 64-bit signed int is 19) */
-    *cchars = sxc_alloc(context, 20 + 1);
-
-    /* try to format as long integer first, if there is no mantissa and the integer portion fits */
-    if (cdouble == (double)(long int)cdouble && sizeof(long int) <= 8) {
-      *length = sprintf(*cchars, "%ld", (long int)cdouble);
-    }
-    /* otherwise format as a floating point in scientific notation:
-     *    |<-------20------->|
-     *    +1.000000000000e+000
-     *       |<---12--->|
-     */
-    else {
-      *length = sprintf(*cchars, "%1.12e", cdouble);
-    }
+    /* format the shortest number that round-trips */
+    ALLOC_OR_FAIL(*cchars, context, SXC_NUMBER_DOUBLE_MAX_CHARS + 1, SXC_MEMORY_ALIGN)
+    *length = sxc_number_fromdouble(cdouble, *cchars);
+    (*cchars)[*length] = '\0';
   }
   return SXC_SUCCESS;
 }
@@ -130,6 +231,29 @@ static int sstring_to_cchars(SxcContext* context, void* sstring, SxcStringBindin
   return SXC_SUCCESS;
 }
 
+static int sstring_to_string(SxcContext* context, void* sstring, SxcStringBinding* sstring_binding, SxcString** string) {
+  ALLOC_OR_FAIL(*string, context, sizeof(SxcString), SXC_MEMORY_ALIGN)
+  (*string)->underlying = sstring;
+  (*string)->binding = sstring_binding;
+  (*string)->context = context;
+  return sstring_to_cchars(context, sstring, sstring_binding, &((*string)->data), &((*string)->length));
+}
+
+/* sets array to the C array behind map, if it wraps a buffer */
+static int map_to_array(SxcMap* map, SxcValue* array) {
+  SxcBuffer* buffer = map->binding->getbuffer == NULL ? NULL
+      : (map->binding->getbuffer)(map->underlying, map->context);
+
+  if (buffer == NULL) {
+    return SXC_FAILURE;
+  }
+  array->context = map->context;
+  array->type = buffer->type;
+  array->data._array_store.array = buffer->array;
+  array->data._array_store.length = buffer->length;
+  return SXC_SUCCESS;
+}
+
 
 /***** Conversion Functions *****/
 
@@ -167,6 +291,10 @@ static int to_cbool(SxcValue* value, bool* dest) {
       *dest = (value->data.cdouble != 0.0);
       return SXC_SUCCESS;
 
+    case sxc_cint64:
+      *dest = (value->data.cint64 != 0);
+      return SXC_SUCCESS;
+
         /* DRY readability macro */
         #define FROM_DOUBLE(CONVERSION)             \
           ((CONVERSION) == SXC_SUCCESS ?            \
@@ -200,7 +328,6 @@ static int to_cbool(SxcValue* value, bool* dest) {
 static int to_cint(SxcValue* value, int* dest) {
   char* cchars;
   int length;
-  double cdouble;
 
   switch (value->type) {
     case sxc_cint:
@@ -208,36 +335,35 @@ static int to_cint(SxcValue* value, int* dest) {
       return SXC_SUCCESS;
 
     case sxc_cbool:
-      *dest = value->data.cbool;
+      *dest = value->data.cbool ? 1 : 0;
       return SXC_SUCCESS;
 
+    /* NOTE numbers out of range are clamped, the same as in arrays (see
+        sxc_vector.c) */
     case sxc_cdouble:
-      *dest = (int)(value->data.cdouble);
+      *dest = DOUBLE_TO_INT(value->data.cdouble);
       return SXC_SUCCESS;
 
-        /* DRY readability macro */
-        #define FROM_DOUBLE(CONVERSION)             \
-          ((CONVERSION) == SXC_SUCCESS ?            \
-            (*dest = (int)cdouble, SXC_SUCCESS) \
-            : SXC_FAILURE)
+    case sxc_cint64:
+      *dest = (int)SATURATE(value->data.cint64, INT_MIN, INT_MAX);
+      return SXC_SUCCESS;
 
+    /* NOTE strings are parsed as ints rather than as doubles, so "1e3" and
+        "2.5" aren't ints, and out of range values fail rather than wrap */
     case sxc_string:
-      return FROM_DOUBLE(cchars_to_cdouble(value->data.string->data, value->data.string->length,
-                          value->data.string->binding->is_null_terminated, &cdouble));
+      return cchars_to_cint(value->data.string->data, value->data.string->length,
+                value->data.string->binding->is_null_terminated, dest);
 
     case sxc_sstring:
-      return FROM_DOUBLE(sstring_to_cchars(value->context, value->data.sstring.underlying,
+      return sstring_to_cchars(value->context, value->data.sstring.underlying,
             value->data.sstring.binding, &cchars, &length)
-        && cchars_to_cdouble(cchars, length, value->data.sstring.binding->is_null_terminated, &cdouble));
+        && cchars_to_cint(cchars, length, value->data.sstring.binding->is_null_terminated, dest);
 
     case sxc_cstring:
-      return FROM_DOUBLE(cchars_to_cdouble(value->data.cstring, -1, true, &cdouble));
+      return cchars_to_cint(value->data.cstring, -1, true, dest);
 
     case sxc_cchars:
-      return FROM_DOUBLE(cchars_to_cdouble(value->data.cchars.array, value->data.cchars.length, false, &cdouble));
-
-        /* macro be gone! */
-        #undef FROM_DOUBLE
+      return cchars_to_cint(value->data.cchars.array, value->data.cchars.length, false, dest);
 
     default:
       return SXC_FAILURE;
@@ -262,6 +388,10 @@ static int to_cdouble(SxcValue* value, double* dest) {
       *dest = (double)(value->data.cint);
       return SXC_SUCCESS;
 
+    case sxc_cint64:
+      *dest = (double)(value->data.cint64);
+      return SXC_SUCCESS;
+
     case sxc_string:
       return cchars_to_cdouble(value->data.string->data, value->data.string->length,
                                 value->data.string->binding->is_null_terminated, dest);
@@ -283,9 +413,108 @@ static int to_cdouble(SxcValue* value, double* dest) {
 }
 
 
+static int to_cint64(SxcValue* value, SxcInt64* dest) {
+  char* cchars;
+  int length;
+
+  switch (value->type) {
+    case sxc_cint64:
+      *dest = value->data.cint64;
+      return SXC_SUCCESS;
+
+    case sxc_cint:
+      *dest = value->data.cint;
+      return SXC_SUCCESS;
+
+    case sxc_cbool:
+      *dest = value->data.cbool;
+      return SXC_SUCCESS;
+
+    /* NOTE doubles out of range are clamped (see to_cint) */
+    case sxc_cdouble:
+      *dest = DOUBLE_TO_INT64(value->data.cdouble);
+      return SXC_SUCCESS;
+
+    /* NOTE see to_cint() */
+    case sxc_string:
+      return cchars_to_cint64(value->data.string->data, value->data.string->length,
+                value->data.string->binding->is_null_terminated, dest);
+
+    case sxc_sstring:
+      return sstring_to_cchars(value->context, value->data.sstring.underlying,
+            value->data.sstring.binding, &cchars, &length)
+        && cchars_to_cint64(cchars, length, value->data.sstring.binding->is_null_terminated, dest);
+
+    case sxc_cstring:
+      return cchars_to_cint64(value->data.cstring, -1, true, dest);
+
+    case sxc_cchars:
+      return cchars_to_cint64(value->data.cchars.array, value->data.cchars.length, false, dest);
+
+    default:
+      return SXC_FAILURE;
+  }
+}
+
+
+/* NOTE the narrow array types have no scalar counterpart, so these only
+    convert elements (see ARRAY2ARRAY and MAP2ARRAY) */
+static int to_cfloat(SxcValue* value, float* dest) {
+  double cdouble;
+
+  if (!to_cdouble(value, &cdouble)) {
+    return SXC_FAILURE;
+  }
+  *dest = (float)cdouble;
+  return SXC_SUCCESS;
+}
+
+static int to_cint8(SxcValue* value, int8* dest) {
+  double cdouble;
+
+  if (!to_cdouble(value, &cdouble)) {
+    return SXC_FAILURE;
+  }
+  *dest = (int8)SATURATE(cdouble, SCHAR_MIN, SCHAR_MAX);
+  return SXC_SUCCESS;
+}
+
+static int to_cuint8(SxcValue* value, uint8* dest) {
+  double cdouble;
+
+  if (!to_cdouble(value, &cdouble)) {
+    return SXC_FAILURE;
+  }
+  *dest = (uint8)SATURATE(cdouble, 0, UCHAR_MAX);
+  return SXC_SUCCESS;
+}
+
+static int to_cint16(SxcValue* value, int16* dest) {
+  double cdouble;
+
+  if (!to_cdouble(value, &cdouble)) {
+    return SXC_FAILURE;
+  }
+  *dest = (int16)SATURATE(cdouble, SHRT_MIN, SHRT_MAX);
+  return SXC_SUCCESS;
+}
+
+static int to_cuint16(SxcValue* value, uint16* dest) {
+  double cdouble;
+
+  if (!to_cdouble(value, &cdouble)) {
+    return SXC_FAILURE;
+  }
+  *dest = (uint16)SATURATE(cdouble, 0, USHRT_MAX);
+  return SXC_SUCCESS;
+}
+
+
 static int to_string(SxcValue* value, SxcString** dest) {
   char* cchars;
   int length;
+  void* sstring;
+  SxcStringBinding* sstring_binding;
 
   switch (value->type) {
     case sxc_string:
@@ -293,12 +522,8 @@ static int to_string(SxcValue* value, SxcString** dest) {
       return SXC_SUCCESS;
 
     case sxc_sstring:
-      *dest = (SxcString*)sxc_alloc(value->context, sizeof(SxcString));
-      (*dest)->underlying = value->data.sstring.underlying;
-      (*dest)->binding = value->data.sstring.binding;
-      (*dest)->context = value->context;
-      sstring_to_cchars(value->context, (*dest)->underlying, (*dest)->binding, &((*dest)->data), &((*dest)->length));
-      return SXC_SUCCESS;
+      return sstring_to_string(value->context, value->data.sstring.underlying,
+              value->data.sstring.binding, dest);
 
     case sxc_cstring:
       return cchars_to_string(value->context, value->data.cstring,
@@ -313,8 +538,12 @@ static int to_string(SxcValue* value, SxcString** dest) {
           && cchars_to_string(value->context, cchars, length, dest);
 
     case sxc_cint:
-      return cint_to_cchars(value->context, value->data.cint, &cchars, &length)
-          && cchars_to_string(value->context, cchars, length, dest);
+      return cint_to_sstring(value->context, value->data.cint, &sstring, &sstring_binding)
+          && sstring_to_string(value->context, sstring, sstring_binding, dest);
+
+    case sxc_cint64:
+      return cint64_to_sstring(value->context, value->data.cint64, &sstring, &sstring_binding)
+          && sstring_to_string(value->context, sstring, sstring_binding, dest);
 
     case sxc_cdouble:
       return cdouble_to_cchars(value->context, value->data.cdouble, &cchars, &length)
@@ -355,8 +584,10 @@ static int to_sstring(SxcValue* value, void** dest, SxcStringBinding** dest_bind
           && cchars_to_sstring(value->context, cchars, length, dest, dest_binding);
 
     case sxc_cint:
-      return cint_to_cchars(value->context, value->data.cint, &cchars, &length)
-          && cchars_to_sstring(value->context, cchars, length, dest, dest_binding);
+      return cint_to_sstring(value->context, value->data.cint, dest, dest_binding);
+
+    case sxc_cint64:
+      return cint64_to_sstring(value->context, value->data.cint64, dest, dest_binding);
 
     case sxc_cdouble:
       return cdouble_to_cchars(value->context, value->data.cdouble, &cchars, &length)
@@ -404,6 +635,10 @@ static int to_cstring(SxcValue* value, char** dest) {
       /* NOTE we can assume results from cint_to_cchars are null-terminated */
       return cint_to_cchars(value->context, value->data.cint, dest, &length);
 
+    case sxc_cint64:
+      /* NOTE we can assume results from cint64_to_cchars are null-terminated */
+      return cint64_to_cchars(value->context, value->data.cint64, dest, &length);
+
     case sxc_cdouble:
       /* NOTE we can assume results from cdouble_to_cchars are null-terminated */
       return cdouble_to_cchars(value->context, value->data.cdouble, dest, &length);
@@ -430,18 +665,43 @@ static int to_smap(SxcValue* value, void** dest, SxcMapBinding** dest_binding) {
       return SXC_SUCCESS;
 
         /***** straightforward but verbose (and error prone) ==> macro! *****/
+        /* NOTE the callers paste the type and array, since FROM_CTYPE may be a
+            macro itself (bool) */
+        #define SET_RANGE(UNDERLYING, BINDING, TYPE, ARRAY)                       \
+          ((BINDING)->intsetrange != NULL                                         \
+            && ((BINDING)->intsetrange)((UNDERLYING), 0, (ARRAY).length, (TYPE),  \
+              (ARRAY).array, value->context))
+
         #define ARRAY2SMAP(FROM_CTYPE)                                            \
           tmp_value.context = value->context;                                     \
           /* create map */                                                        \
-          (value->context->binding->map_new)(MAPTYPE_LIST, &tmp_value);           \
+          (value->context->binding->map_new)(MAPTYPE_LIST,                        \
+            value->data.c##FROM_CTYPE##s.length, 0, &tmp_value);                  \
           *dest = tmp_value.data.smap.underlying;                                 \
           *dest_binding = tmp_value.data.smap.binding;                            \
-          /* put values in map */                                                 \
+          /* put values in map (all at once, if the binding can) */               \
           tmp_value.type = sxc_c##FROM_CTYPE;                                     \
-          for (i = 0; i < value->data.c##FROM_CTYPE##s.length; i += 1) {          \
+          i = SET_RANGE(*dest, *dest_binding, sxc_c##FROM_CTYPE##s,               \
+              value->data.c##FROM_CTYPE##s) ? value->data.c##FROM_CTYPE##s.length : 0; \
+          for (; i < value->data.c##FROM_CTYPE##s.length; i += 1) {           \
             tmp_value.data.c##FROM_CTYPE = value->data.c##FROM_CTYPE##s.array[i]; \
             ((*dest_binding)->intset)(*dest, i, &tmp_value);                      \
           }
+
+        /* NOTE narrow array elements are widened to a primitive type */
+        #define NARROWS2SMAP(FROM_CTYPE, WIDE_CTYPE)                              \
+          tmp_value.context = value->context;                                     \
+          (value->context->binding->map_new)(MAPTYPE_LIST,                        \
+            value->data.c##FROM_CTYPE##s.length, 0, &tmp_value);                  \
+          *dest = tmp_value.data.smap.underlying;                                 \
+          *dest_binding = tmp_value.data.smap.binding;                            \
+          tmp_value.type = sxc_c##WIDE_CTYPE;                                     \
+          i = SET_RANGE(*dest, *dest_binding, sxc_c##FROM_CTYPE##s,               \
+              value->data.c##FROM_CTYPE##s) ? value->data.c##FROM_CTYPE##s.length : 0; \
+          for (; i < value->data.c##FROM_CTYPE##s.length; i += 1) {           \
+            tmp_value.data.c##WIDE_CTYPE = value->data.c##FROM_CTYPE##s.array[i]; \
+            ((*dest_binding)->intset)(*dest, i, &tmp_value);                      \
+          }
         /********************************************************************/
 
     case sxc_cbools:
@@ -460,8 +720,55 @@ static int to_smap(SxcValue* value, void** dest, SxcMapBinding** dest_binding) {
       ARRAY2SMAP(string)
       return SXC_SUCCESS;
 
-        /***** macro be gone! *****/
+    case sxc_cint64s:
+      ARRAY2SMAP(int64)
+      return SXC_SUCCESS;
+
+    case sxc_cfloats:
+      NARROWS2SMAP(float, double)
+      return SXC_SUCCESS;
+
+    case sxc_cint8s:
+      NARROWS2SMAP(int8, int)
+      return SXC_SUCCESS;
+
+    case sxc_cuint8s:
+      NARROWS2SMAP(uint8, int)
+      return SXC_SUCCESS;
+
+    case sxc_cint16s:
+      NARROWS2SMAP(int16, int)
+      return SXC_SUCCESS;
+
+    case sxc_cuint16s:
+      NARROWS2SMAP(uint16, int)
+      return SXC_SUCCESS;
+
+    /* NOTE elements become script strings, since a binding's intset() only
+        takes primitives and script types */
+    case sxc_cstringrefs:
+      tmp_value.context = value->context;
+      (value->context->binding->map_new)(MAPTYPE_LIST,
+        value->data.cstringrefs.length, 0, &tmp_value);
+      *dest = tmp_value.data.smap.underlying;
+      *dest_binding = tmp_value.data.smap.binding;
+      for (i = 0; i < value->data.cstringrefs.length; i += 1) {
+        if (value->data.cstringrefs.array[i].data == NULL) {
+          sxc_value_set(&tmp_value, sxc_null);
+        } else {
+          tmp_value.type = sxc_sstring;
+          cchars_to_sstring(value->context, value->data.cstringrefs.array[i].data,
+            value->data.cstringrefs.array[i].length, &tmp_value.data.sstring.underlying,
+            &tmp_value.data.sstring.binding);
+        }
+        ((*dest_binding)->intset)(*dest, i, &tmp_value);
+      }
+      return SXC_SUCCESS;
+
+        /***** macros be gone! *****/
+        #undef SET_RANGE
         #undef ARRAY2SMAP
+        #undef NARROWS2SMAP
 
     default:
       return SXC_FAILURE;
@@ -480,7 +787,7 @@ static int to_map(SxcValue* value, SxcMap** dest) {
 
     default:
       if (to_smap(value, &smap, &smap_binding)) {
-        *dest = (SxcMap*)sxc_alloc(value->context, sizeof(SxcMap));
+        ALLOC_OR_FAIL(*dest, value->context, sizeof(SxcMap), SXC_MEMORY_ALIGN)
         (*dest)->underlying = smap;
         (*dest)->binding = smap_binding;
         (*dest)->context = value->context;
@@ -530,7 +837,7 @@ static int to_func(SxcValue* value, SxcFunc** dest) {
 
     default:
       if (to_sfunc(value, &sfunc, &sfunc_binding)) {
-        *dest = (SxcFunc*)sxc_alloc(value->context, sizeof(SxcFunc));
+        ALLOC_OR_FAIL(*dest, value->context, sizeof(SxcFunc), SXC_MEMORY_ALIGN)
         (*dest)->underlying = sfunc;
         (*dest)->binding = sfunc_binding;
         (*dest)->context = value->context;
@@ -630,6 +937,9 @@ static int to_cchars(SxcValue* value, char** dest, int* dest_len) {
     case sxc_cint:
       return cint_to_cchars(value->context, value->data.cint, dest, dest_len);
 
+    case sxc_cint64:
+      return cint64_to_cchars(value->context, value->data.cint64, dest, dest_len);
+
     case sxc_cdouble:
       return cdouble_to_cchars(value->context, value->data.cdouble, dest, dest_len);
 
@@ -650,14 +960,66 @@ static int to_cchars(SxcValue* value, char** dest, int* dest_len) {
 
 #define PRIMITIVES2PRIMITIVES(FROM_CTYPE, TO_CTYPE)                       \
   *dest_len = value->data.c##FROM_CTYPE##s.length;                        \
-  *dest = sxc_alloc(value->context, sizeof(TO_CTYPE) * (*dest_len));      \
+  ALLOC_OR_FAIL(*dest, value->context,                                    \
+      sizeof(TO_CTYPE) * (*dest_len), SXC_MEMORY_ARRAY_ALIGN)             \
   for (i = 0; i < *dest_len; i += 1) {                                    \
     (*dest)[i] = (TO_CTYPE)value->data.c##FROM_CTYPE##s.array[i];         \
   }
 
+/* NOTE a nonzero element is true, even if casting it to bool would not be */
+#define PRIMITIVES2BOOLS(FROM_CTYPE)                                      \
+  *dest_len = value->data.c##FROM_CTYPE##s.length;                        \
+  ALLOC_OR_FAIL(*dest, value->context,                                    \
+      sizeof(bool) * (*dest_len), SXC_MEMORY_ARRAY_ALIGN)                 \
+  for (i = 0; i < *dest_len; i += 1) {                                    \
+    (*dest)[i] = (value->data.c##FROM_CTYPE##s.array[i] != 0);            \
+  }
+
+/* NOTE these pairs are converted with SIMD where available (see sxc_vector.c) */
+#define VECTOR2PRIMITIVES(FROM_CTYPE, TO_CTYPE)                           \
+  *dest_len = value->data.c##FROM_CTYPE##s.length;                        \
+  ALLOC_OR_FAIL(*dest, value->context,                                    \
+      sizeof(TO_CTYPE) * (*dest_len), SXC_MEMORY_ARRAY_ALIGN)             \
+  sxc_vector_##FROM_CTYPE##sto##TO_CTYPE##s(                              \
+      value->data.c##FROM_CTYPE##s.array, *dest, *dest_len);
+
+/* NOTE these parse the whole array in one pass (see sxc_number.c) */
+#define STRINGS2PRIMITIVES(TO_CTYPE)                                      \
+  *dest_len = value->data.cstrings.length;                                \
+  ALLOC_OR_FAIL(*dest, value->context,                                    \
+      sizeof(TO_CTYPE) * (*dest_len), SXC_MEMORY_ARRAY_ALIGN)             \
+  sxc_number_parse##TO_CTYPE##s(value->data.cstrings.array, *dest_len, *dest, NULL);
+
+#define PRIMITIVES2NARROWS(FROM_CTYPE, TO_CTYPE, MIN, MAX)                \
+  *dest_len = value->data.c##FROM_CTYPE##s.length;                        \
+  ALLOC_OR_FAIL(*dest, value->context,                                    \
+      sizeof(TO_CTYPE) * (*dest_len), SXC_MEMORY_ARRAY_ALIGN)             \
+  for (i = 0; i < *dest_len; i += 1) {                                    \
+    (*dest)[i] = (TO_CTYPE)SATURATE(value->data.c##FROM_CTYPE##s.array[i], MIN, MAX); \
+  }
+
+/* NOTE booleans are always in range, so they're converted as 1 or 0 */
+#define BOOLS2NARROWS(TO_CTYPE)                                           \
+  *dest_len = value->data.cbools.length;                                  \
+  ALLOC_OR_FAIL(*dest, value->context,                                    \
+      sizeof(TO_CTYPE) * (*dest_len), SXC_MEMORY_ARRAY_ALIGN)             \
+  for (i = 0; i < *dest_len; i += 1) {                                    \
+    (*dest)[i] = (TO_CTYPE)(value->data.cbools.array[i] != 0);            \
+  }
+
+/* NOTE INT_MAX isn't exact as a float, so floats are clamped as doubles */
+#define FLOATS2INTS                                                       \
+  *dest_len = value->data.cfloats.length;                                 \
+  ALLOC_OR_FAIL(*dest, value->context,                                    \
+      sizeof(int) * (*dest_len), SXC_MEMORY_ARRAY_ALIGN)                  \
+  for (i = 0; i < *dest_len; i += 1) {                                    \
+    (*dest)[i] = DOUBLE_TO_INT((double)value->data.cfloats.array[i]);     \
+  }
+
 #define ARRAY2ARRAY(FROM_CTYPE, TO_CTYPE)                                 \
   *dest_len = value->data.c##FROM_CTYPE##s.length;                        \
-  *dest = sxc_alloc(value->context, sizeof(TO_CTYPE) * (*dest_len));      \
+  ALLOC_OR_FAIL(*dest, value->context,                                    \
+      sizeof(TO_CTYPE) * (*dest_len), SXC_MEMORY_ARRAY_ALIGN)             \
   tmp_value.context = value->context;                                     \
   tmp_value.type = sxc_c##FROM_CTYPE;                                     \
   for (i = 0; i < *dest_len; i += 1) {                                    \
@@ -667,23 +1029,49 @@ static int to_cchars(SxcValue* value, char** dest, int* dest_len) {
     }                                                                     \
   }
 
+/* NOTE narrow array elements are widened to a primitive type first */
+#define NARROWS2ARRAY(FROM_CTYPE, WIDE_CTYPE, TO_CTYPE)                   \
+  *dest_len = value->data.c##FROM_CTYPE##s.length;                        \
+  ALLOC_OR_FAIL(*dest, value->context,                                    \
+      sizeof(TO_CTYPE) * (*dest_len), SXC_MEMORY_ARRAY_ALIGN)             \
+  tmp_value.context = value->context;                                     \
+  tmp_value.type = sxc_c##WIDE_CTYPE;                                     \
+  for (i = 0; i < *dest_len; i += 1) {                                    \
+    tmp_value.data.c##WIDE_CTYPE = value->data.c##FROM_CTYPE##s.array[i]; \
+    if (!to_c##TO_CTYPE(&tmp_value, &((*dest)[i]))) {                     \
+      (*dest)[i] = (TO_CTYPE)0;                                           \
+    }                                                                     \
+  }
+
+/* NOTE buffers are converted like the C array they hold (so a buffer of the
+    requested type isn't copied), and other maps' elements are read all at
+    once, if the binding can */
 #define MAP2ARRAY(FROM_MAP, TO_CTYPE)                                     \
+  if (map_to_array((FROM_MAP), &tmp_value)) {                             \
+    return to_c##TO_CTYPE##s(&tmp_value, dest, dest_len);                 \
+  }                                                                       \
   tmp_value.data.cint = sxc_map_length((FROM_MAP));                       \
   if (tmp_value.data.cint < 0) {                                          \
     return SXC_FAILURE;                                                   \
   }                                                                       \
   *dest_len = tmp_value.data.cint;                                        \
-  *dest = sxc_alloc(value->context, sizeof(TO_CTYPE) * (*dest_len));      \
+  ALLOC_OR_FAIL(*dest, value->context,                                    \
+      sizeof(TO_CTYPE) * (*dest_len), SXC_MEMORY_ARRAY_ALIGN)             \
+  if ((FROM_MAP)->binding->intgetrange != NULL                            \
+      && ((FROM_MAP)->binding->intgetrange)((FROM_MAP)->underlying, 0,    \
+        *dest_len, sxc_c##TO_CTYPE##s, *dest, value->context)) {          \
+    return SXC_SUCCESS;                                                   \
+  }                                                                       \
   tmp_value.context = value->context;                                     \
   for (i = 0; i < *dest_len; i += 1) {                                    \
-    ((FROM_MAP)->binding->intget)((FROM_MAP), i, &tmp_value);             \
+    ((FROM_MAP)->binding->intget)((FROM_MAP)->underlying, i, &tmp_value); \
     if (!to_c##TO_CTYPE(&tmp_value, &((*dest)[i]))) {                     \
       (*dest)[i] = (TO_CTYPE)0;                                           \
     }                                                                     \
   }
 
 
-static int to_cbools(SxcValue* value, char** dest, int* dest_len) {
+static int to_cbools(SxcValue* value, bool** dest, int* dest_len) {
   SxcValue tmp_value;
   SxcMap tmp_map;
   int i;
@@ -695,17 +1083,41 @@ static int to_cbools(SxcValue* value, char** dest, int* dest_len) {
       return SXC_SUCCESS;
 
     case sxc_cints:
-      PRIMITIVES2PRIMITIVES(int, bool)
+      VECTOR2PRIMITIVES(int, bool)
       return SXC_SUCCESS;
 
     case sxc_cdoubles:
-      PRIMITIVES2PRIMITIVES(double, bool)
+      VECTOR2PRIMITIVES(double, bool)
       return SXC_SUCCESS;
 
     case sxc_cstrings:
       ARRAY2ARRAY(string, bool)
       return SXC_SUCCESS;
 
+    case sxc_cint64s:
+      PRIMITIVES2BOOLS(int64)
+      return SXC_SUCCESS;
+
+    case sxc_cfloats:
+      PRIMITIVES2BOOLS(float)
+      return SXC_SUCCESS;
+
+    case sxc_cint8s:
+      PRIMITIVES2BOOLS(int8)
+      return SXC_SUCCESS;
+
+    case sxc_cuint8s:
+      PRIMITIVES2BOOLS(uint8)
+      return SXC_SUCCESS;
+
+    case sxc_cint16s:
+      PRIMITIVES2BOOLS(int16)
+      return SXC_SUCCESS;
+
+    case sxc_cuint16s:
+      PRIMITIVES2BOOLS(uint16)
+      return SXC_SUCCESS;
+
     case sxc_map:
       MAP2ARRAY(value->data.map, bool)
       return SXC_SUCCESS;
@@ -735,15 +1147,39 @@ static int to_cints(SxcValue* value, int** dest, int* dest_len) {
       return SXC_SUCCESS;
 
     case sxc_cbools:
-      PRIMITIVES2PRIMITIVES(bool, int)
+      VECTOR2PRIMITIVES(bool, int)
       return SXC_SUCCESS;
 
     case sxc_cdoubles:
-      PRIMITIVES2PRIMITIVES(double, int)
+      VECTOR2PRIMITIVES(double, int)
       return SXC_SUCCESS;
 
     case sxc_cstrings:
-      ARRAY2ARRAY(string, int)
+      STRINGS2PRIMITIVES(int)
+      return SXC_SUCCESS;
+
+    case sxc_cint64s:
+      PRIMITIVES2NARROWS(int64, int, INT_MIN, INT_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cfloats:
+      FLOATS2INTS
+      return SXC_SUCCESS;
+
+    case sxc_cint8s:
+      PRIMITIVES2PRIMITIVES(int8, int)
+      return SXC_SUCCESS;
+
+    case sxc_cuint8s:
+      PRIMITIVES2PRIMITIVES(uint8, int)
+      return SXC_SUCCESS;
+
+    case sxc_cint16s:
+      PRIMITIVES2PRIMITIVES(int16, int)
+      return SXC_SUCCESS;
+
+    case sxc_cuint16s:
+      PRIMITIVES2PRIMITIVES(uint16, int)
       return SXC_SUCCESS;
 
     case sxc_map:
@@ -775,15 +1211,39 @@ static int to_cdoubles(SxcValue* value, double** dest, int* dest_len) {
       return SXC_SUCCESS;
 
     case sxc_cbools:
-      PRIMITIVES2PRIMITIVES(bool, double)
+      VECTOR2PRIMITIVES(bool, double)
       return SXC_SUCCESS;
 
     case sxc_cints:
-      PRIMITIVES2PRIMITIVES(int, double)
+      VECTOR2PRIMITIVES(int, double)
       return SXC_SUCCESS;
 
     case sxc_cstrings:
-      ARRAY2ARRAY(string, double)
+      STRINGS2PRIMITIVES(double)
+      return SXC_SUCCESS;
+
+    case sxc_cint64s:
+      PRIMITIVES2PRIMITIVES(int64, double)
+      return SXC_SUCCESS;
+
+    case sxc_cfloats:
+      PRIMITIVES2PRIMITIVES(float, double)
+      return SXC_SUCCESS;
+
+    case sxc_cint8s:
+      PRIMITIVES2PRIMITIVES(int8, double)
+      return SXC_SUCCESS;
+
+    case sxc_cuint8s:
+      PRIMITIVES2PRIMITIVES(uint8, double)
+      return SXC_SUCCESS;
+
+    case sxc_cint16s:
+      PRIMITIVES2PRIMITIVES(int16, double)
+      return SXC_SUCCESS;
+
+    case sxc_cuint16s:
+      PRIMITIVES2PRIMITIVES(uint16, double)
       return SXC_SUCCESS;
 
     case sxc_map:
@@ -806,6 +1266,7 @@ static int to_cdoubles(SxcValue* value, double** dest, int* dest_len) {
 static int to_cstrings(SxcValue* value, char*** dest, int* dest_len) {
   SxcValue tmp_value;
   SxcMap tmp_map;
+  SxcStringRef* ref;
   int i;
 
   switch (value->type) {
@@ -814,6 +1275,20 @@ static int to_cstrings(SxcValue* value, char*** dest, int* dest_len) {
       *dest = value->data.cstrings.array;
       return SXC_SUCCESS;
 
+    /* NOTE borrowed strings aren't known to be null-terminated, so they're
+        copied */
+    case sxc_cstringrefs:
+      *dest_len = value->data.cstringrefs.length;
+      ALLOC_OR_FAIL(*dest, value->context, sizeof(char*) * (*dest_len), SXC_MEMORY_ARRAY_ALIGN)
+      for (i = 0; i < *dest_len; i += 1) {
+        ref = &(value->data.cstringrefs.array[i]);
+        (*dest)[i] = NULL;
+        if (ref->data != NULL) {
+          cchars_to_cstring(value->context, ref->data, ref->length, false, &((*dest)[i]));
+        }
+      }
+      return SXC_SUCCESS;
+
     case sxc_cbools:
       ARRAY2ARRAY(bool, string)
       return SXC_SUCCESS;
@@ -826,6 +1301,30 @@ static int to_cstrings(SxcValue* value, char*** dest, int* dest_len) {
       ARRAY2ARRAY(double, string)
       return SXC_SUCCESS;
 
+    case sxc_cint64s:
+      ARRAY2ARRAY(int64, string)
+      return SXC_SUCCESS;
+
+    case sxc_cfloats:
+      NARROWS2ARRAY(float, double, string)
+      return SXC_SUCCESS;
+
+    case sxc_cint8s:
+      NARROWS2ARRAY(int8, int, string)
+      return SXC_SUCCESS;
+
+    case sxc_cuint8s:
+      NARROWS2ARRAY(uint8, int, string)
+      return SXC_SUCCESS;
+
+    case sxc_cint16s:
+      NARROWS2ARRAY(int16, int, string)
+      return SXC_SUCCESS;
+
+    case sxc_cuint16s:
+      NARROWS2ARRAY(uint16, int, string)
+      return SXC_SUCCESS;
+
     case sxc_map:
       MAP2ARRAY(value->data.map, string)
       return SXC_SUCCESS;
@@ -843,82 +1342,775 @@ static int to_cstrings(SxcValue* value, char*** dest, int* dest_len) {
 }
 
 
-/***** macros be gone! *****/
-#undef PRIMITIVES2PRIMITIVES
-#undef ARRAY2ARRAY
-#undef MAP2ARRAY
-
+static int to_cint64s(SxcValue* value, SxcInt64** dest, int* dest_len) {
+  SxcValue tmp_value;
+  SxcMap tmp_map;
+  int i;
 
+  switch (value->type) {
+    case sxc_cint64s:
+      *dest_len = value->data.cint64s.length;
+      *dest = value->data.cint64s.array;
+      return SXC_SUCCESS;
 
-/***** SxcValue Functions *****/
+    case sxc_cbools:
+      PRIMITIVES2PRIMITIVES(bool, int64)
+      return SXC_SUCCESS;
 
-int sxc_value_getv(SxcValue* value, SxcDataType type, va_list varg) {
-  /* these variables are necessary because evaluation of function arguments in C
-      is not well-defined (god knows why), thus the va_arg macro gets confused
-      when used as a to_XXXX() arg */
-  void* dest;
-  void* dest_binding;
-  int* dest_len;
+    case sxc_cints:
+      PRIMITIVES2PRIMITIVES(int, int64)
+      return SXC_SUCCESS;
 
-  if (type != sxc_null) {
-    dest = va_arg(varg, void*);
-  }
+    case sxc_cdoubles:
+      ARRAY2ARRAY(double, int64)
+      return SXC_SUCCESS;
+
+    case sxc_cstrings:
+      ARRAY2ARRAY(string, int64)
+      return SXC_SUCCESS;
+
+    case sxc_cfloats:
+      NARROWS2ARRAY(float, double, int64)
+      return SXC_SUCCESS;
+
+    case sxc_cint8s:
+      PRIMITIVES2PRIMITIVES(int8, int64)
+      return SXC_SUCCESS;
+
+    case sxc_cuint8s:
+      PRIMITIVES2PRIMITIVES(uint8, int64)
+      return SXC_SUCCESS;
+
+    case sxc_cint16s:
+      PRIMITIVES2PRIMITIVES(int16, int64)
+      return SXC_SUCCESS;
+
+    case sxc_cuint16s:
+      PRIMITIVES2PRIMITIVES(uint16, int64)
+      return SXC_SUCCESS;
 
-  switch (type) {
-    case sxc_cbool:
-      return to_cbool(value, (bool*)dest);
-    case sxc_cint:
-      return to_cint(value, (int*)dest);
-    case sxc_cdouble:
-      return to_cdouble(value, (double*)dest);
-
-    case sxc_string:
-      return to_string(value, (SxcString**)dest);
     case sxc_map:
-      return to_map(value, (SxcMap**)dest);
-    case sxc_func:
-      return to_func(value, (SxcFunc**)dest);
+      MAP2ARRAY(value->data.map, int64)
+      return SXC_SUCCESS;
 
-    case sxc_sstring:
-      dest_binding = va_arg(varg, SxcStringBinding**);
-      return to_sstring(value, (void**)dest, (SxcStringBinding**)dest_binding);
     case sxc_smap:
-      dest_binding = va_arg(varg, SxcMapBinding**);
-      return to_smap(value, (void**)dest, (SxcMapBinding**)dest_binding);
-    case sxc_sfunc:
-      dest_binding = va_arg(varg, SxcFuncBinding**);
-      return to_sfunc(value, (void**)dest, (SxcFuncBinding**)dest_binding);
+      tmp_map.underlying = value->data.smap.underlying;
+      tmp_map.binding = value->data.smap.binding;
+      tmp_map.context = value->context;
+      MAP2ARRAY(&tmp_map, int64)
+      return SXC_SUCCESS;
+
+    default:
+      return SXC_FAILURE;
+  }
+}
+
+
+static int to_cfloats(SxcValue* value, float** dest, int* dest_len) {
+  SxcValue tmp_value;
+  SxcMap tmp_map;
+  int i;
+
+  switch (value->type) {
+    case sxc_cfloats:
+      *dest_len = value->data.cfloats.length;
+      *dest = value->data.cfloats.array;
+      return SXC_SUCCESS;
 
-    case sxc_cstring:
-      return to_cstring(value, (char**)dest);
-    case sxc_cpointer:
-      return to_cpointer(value, (void**)dest);
-    case sxc_cfunc:
-      return to_cfunc(value, (SxcLibFunc**)dest);
-    case sxc_cchars:
-      dest_len = va_arg(varg, int*);
-      return to_cchars(value, (char**)dest, dest_len);
     case sxc_cbools:
-      dest_len = va_arg(varg, int*);
-      return to_cbools(value, (char**)dest, dest_len);
+      PRIMITIVES2PRIMITIVES(bool, float)
+      return SXC_SUCCESS;
+
     case sxc_cints:
-      dest_len = va_arg(varg, int*);
-      return to_cints(value, (int**)dest, dest_len);
+      PRIMITIVES2PRIMITIVES(int, float)
+      return SXC_SUCCESS;
+
     case sxc_cdoubles:
-      dest_len = va_arg(varg, int*);
-      return to_cdoubles(value, (double**)dest, dest_len);
+      PRIMITIVES2PRIMITIVES(double, float)
+      return SXC_SUCCESS;
+
+    case sxc_cint64s:
+      PRIMITIVES2PRIMITIVES(int64, float)
+      return SXC_SUCCESS;
+
+    case sxc_cint8s:
+      PRIMITIVES2PRIMITIVES(int8, float)
+      return SXC_SUCCESS;
+
+    case sxc_cuint8s:
+      PRIMITIVES2PRIMITIVES(uint8, float)
+      return SXC_SUCCESS;
+
+    case sxc_cint16s:
+      PRIMITIVES2PRIMITIVES(int16, float)
+      return SXC_SUCCESS;
+
+    case sxc_cuint16s:
+      PRIMITIVES2PRIMITIVES(uint16, float)
+      return SXC_SUCCESS;
+
     case sxc_cstrings:
-      dest_len = va_arg(varg, int*);
-      return to_cstrings(value, (char***)dest, dest_len);
+      ARRAY2ARRAY(string, float)
+      return SXC_SUCCESS;
+
+    case sxc_map:
+      MAP2ARRAY(value->data.map, float)
+      return SXC_SUCCESS;
+
+    case sxc_smap:
+      tmp_map.underlying = value->data.smap.underlying;
+      tmp_map.binding = value->data.smap.binding;
+      tmp_map.context = value->context;
+      MAP2ARRAY(&tmp_map, float)
+      return SXC_SUCCESS;
 
     default:
-      if (type == sxc_value) {
-        *(va_arg(varg, SxcValue*)) = *value;
-        return SXC_SUCCESS;
-      } else {
+      return SXC_FAILURE;
+  }
+}
+
+
+static int to_cint8s(SxcValue* value, signed char** dest, int* dest_len) {
+  SxcValue tmp_value;
+  SxcMap tmp_map;
+  int i;
+
+  switch (value->type) {
+    case sxc_cint8s:
+      *dest_len = value->data.cint8s.length;
+      *dest = value->data.cint8s.array;
+      return SXC_SUCCESS;
+
+    case sxc_cbools:
+      BOOLS2NARROWS(int8)
+      return SXC_SUCCESS;
+
+    case sxc_cints:
+      PRIMITIVES2NARROWS(int, int8, SCHAR_MIN, SCHAR_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cdoubles:
+      PRIMITIVES2NARROWS(double, int8, SCHAR_MIN, SCHAR_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cint64s:
+      PRIMITIVES2NARROWS(int64, int8, SCHAR_MIN, SCHAR_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cfloats:
+      PRIMITIVES2NARROWS(float, int8, SCHAR_MIN, SCHAR_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cuint8s:
+      PRIMITIVES2NARROWS(uint8, int8, SCHAR_MIN, SCHAR_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cint16s:
+      PRIMITIVES2NARROWS(int16, int8, SCHAR_MIN, SCHAR_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cuint16s:
+      PRIMITIVES2NARROWS(uint16, int8, SCHAR_MIN, SCHAR_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cstrings:
+      ARRAY2ARRAY(string, int8)
+      return SXC_SUCCESS;
+
+    case sxc_map:
+      MAP2ARRAY(value->data.map, int8)
+      return SXC_SUCCESS;
+
+    case sxc_smap:
+      tmp_map.underlying = value->data.smap.underlying;
+      tmp_map.binding = value->data.smap.binding;
+      tmp_map.context = value->context;
+      MAP2ARRAY(&tmp_map, int8)
+      return SXC_SUCCESS;
+
+    default:
+      return SXC_FAILURE;
+  }
+}
+
+
+static int to_cuint8s(SxcValue* value, unsigned char** dest, int* dest_len) {
+  SxcValue tmp_value;
+  SxcMap tmp_map;
+  int i;
+
+  switch (value->type) {
+    case sxc_cuint8s:
+      *dest_len = value->data.cuint8s.length;
+      *dest = value->data.cuint8s.array;
+      return SXC_SUCCESS;
+
+    case sxc_cbools:
+      BOOLS2NARROWS(uint8)
+      return SXC_SUCCESS;
+
+    case sxc_cints:
+      PRIMITIVES2NARROWS(int, uint8, 0, UCHAR_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cdoubles:
+      PRIMITIVES2NARROWS(double, uint8, 0, UCHAR_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cint64s:
+      PRIMITIVES2NARROWS(int64, uint8, 0, UCHAR_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cfloats:
+      PRIMITIVES2NARROWS(float, uint8, 0, UCHAR_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cint8s:
+      PRIMITIVES2NARROWS(int8, uint8, 0, UCHAR_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cint16s:
+      PRIMITIVES2NARROWS(int16, uint8, 0, UCHAR_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cuint16s:
+      PRIMITIVES2NARROWS(uint16, uint8, 0, UCHAR_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cstrings:
+      ARRAY2ARRAY(string, uint8)
+      return SXC_SUCCESS;
+
+    case sxc_map:
+      MAP2ARRAY(value->data.map, uint8)
+      return SXC_SUCCESS;
+
+    case sxc_smap:
+      tmp_map.underlying = value->data.smap.underlying;
+      tmp_map.binding = value->data.smap.binding;
+      tmp_map.context = value->context;
+      MAP2ARRAY(&tmp_map, uint8)
+      return SXC_SUCCESS;
+
+    default:
+      return SXC_FAILURE;
+  }
+}
+
+
+static int to_cint16s(SxcValue* value, short** dest, int* dest_len) {
+  SxcValue tmp_value;
+  SxcMap tmp_map;
+  int i;
+
+  switch (value->type) {
+    case sxc_cint16s:
+      *dest_len = value->data.cint16s.length;
+      *dest = value->data.cint16s.array;
+      return SXC_SUCCESS;
+
+    case sxc_cbools:
+      BOOLS2NARROWS(int16)
+      return SXC_SUCCESS;
+
+    case sxc_cints:
+      PRIMITIVES2NARROWS(int, int16, SHRT_MIN, SHRT_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cdoubles:
+      PRIMITIVES2NARROWS(double, int16, SHRT_MIN, SHRT_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cint64s:
+      PRIMITIVES2NARROWS(int64, int16, SHRT_MIN, SHRT_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cfloats:
+      PRIMITIVES2NARROWS(float, int16, SHRT_MIN, SHRT_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cint8s:
+      PRIMITIVES2NARROWS(int8, int16, SHRT_MIN, SHRT_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cuint8s:
+      PRIMITIVES2NARROWS(uint8, int16, SHRT_MIN, SHRT_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cuint16s:
+      PRIMITIVES2NARROWS(uint16, int16, SHRT_MIN, SHRT_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cstrings:
+      ARRAY2ARRAY(string, int16)
+      return SXC_SUCCESS;
+
+    case sxc_map:
+      MAP2ARRAY(value->data.map, int16)
+      return SXC_SUCCESS;
+
+    case sxc_smap:
+      tmp_map.underlying = value->data.smap.underlying;
+      tmp_map.binding = value->data.smap.binding;
+      tmp_map.context = value->context;
+      MAP2ARRAY(&tmp_map, int16)
+      return SXC_SUCCESS;
+
+    default:
+      return SXC_FAILURE;
+  }
+}
+
+
+static int to_cuint16s(SxcValue* value, unsigned short** dest, int* dest_len) {
+  SxcValue tmp_value;
+  SxcMap tmp_map;
+  int i;
+
+  switch (value->type) {
+    case sxc_cuint16s:
+      *dest_len = value->data.cuint16s.length;
+      *dest = value->data.cuint16s.array;
+      return SXC_SUCCESS;
+
+    case sxc_cbools:
+      BOOLS2NARROWS(uint16)
+      return SXC_SUCCESS;
+
+    case sxc_cints:
+      PRIMITIVES2NARROWS(int, uint16, 0, USHRT_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cdoubles:
+      PRIMITIVES2NARROWS(double, uint16, 0, USHRT_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cint64s:
+      PRIMITIVES2NARROWS(int64, uint16, 0, USHRT_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cfloats:
+      PRIMITIVES2NARROWS(float, uint16, 0, USHRT_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cint8s:
+      PRIMITIVES2NARROWS(int8, uint16, 0, USHRT_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cuint8s:
+      PRIMITIVES2NARROWS(uint8, uint16, 0, USHRT_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cint16s:
+      PRIMITIVES2NARROWS(int16, uint16, 0, USHRT_MAX)
+      return SXC_SUCCESS;
+
+    case sxc_cstrings:
+      ARRAY2ARRAY(string, uint16)
+      return SXC_SUCCESS;
+
+    case sxc_map:
+      MAP2ARRAY(value->data.map, uint16)
+      return SXC_SUCCESS;
+
+    case sxc_smap:
+      tmp_map.underlying = value->data.smap.underlying;
+      tmp_map.binding = value->data.smap.binding;
+      tmp_map.context = value->context;
+      MAP2ARRAY(&tmp_map, uint16)
+      return SXC_SUCCESS;
+
+    default:
+      return SXC_FAILURE;
+  }
+}
+
+
+/* NOTE strings from a map are borrowed: the binding's intgetrange() or
+    to_cchars() hands out its own storage for them where it can */
+static int to_cstringrefs(SxcValue* value, SxcStringRef** dest, int* dest_len) {
+  SxcValue tmp_value;
+  SxcMap tmp_map;
+  SxcMap* map;
+  char** cstrings;
+  int i;
+
+  switch (value->type) {
+    case sxc_cstringrefs:
+      *dest_len = value->data.cstringrefs.length;
+      *dest = value->data.cstringrefs.array;
+      return SXC_SUCCESS;
+
+    case sxc_map:
+      map = value->data.map;
+      break;
+
+    case sxc_smap:
+      tmp_map.underlying = value->data.smap.underlying;
+      tmp_map.binding = value->data.smap.binding;
+      tmp_map.context = value->context;
+      map = &tmp_map;
+      break;
+
+    /* everything else goes by way of its C strings (e.g. numbers are
+        formatted), which are borrowed in turn */
+    default:
+      if (!to_cstrings(value, &cstrings, dest_len)) {
         return SXC_FAILURE;
       }
+      ALLOC_OR_FAIL(*dest, value->context,
+          sizeof(SxcStringRef) * (*dest_len), SXC_MEMORY_ARRAY_ALIGN)
+      for (i = 0; i < *dest_len; i += 1) {
+        (*dest)[i].data = cstrings[i];
+        (*dest)[i].length = cstrings[i] == NULL ? 0 : strlen(cstrings[i]);
+      }
+      return SXC_SUCCESS;
+  }
+
+  /* buffers are converted like the C array they hold */
+  if (map_to_array(map, &tmp_value)) {
+    return to_cstringrefs(&tmp_value, dest, dest_len);
+  }
+
+  *dest_len = sxc_map_length(map);
+  if (*dest_len < 0) {
+    return SXC_FAILURE;
+  }
+  ALLOC_OR_FAIL(*dest, value->context,
+      sizeof(SxcStringRef) * (*dest_len), SXC_MEMORY_ARRAY_ALIGN)
+  if (map->binding->intgetrange != NULL
+      && (map->binding->intgetrange)(map->underlying, 0, *dest_len,
+        sxc_cstringrefs, *dest, value->context)) {
+    return SXC_SUCCESS;
+  }
+
+  tmp_value.context = value->context;
+  for (i = 0; i < *dest_len; i += 1) {
+    (map->binding->intget)(map->underlying, i, &tmp_value);
+    if (!to_cchars(&tmp_value, &((*dest)[i].data), &((*dest)[i].length))) {
+      (*dest)[i].data = NULL;
+      (*dest)[i].length = 0;
+    }
+  }
+  return SXC_SUCCESS;
+}
+
+
+/***** macros be gone! *****/
+#undef PRIMITIVES2PRIMITIVES
+#undef PRIMITIVES2BOOLS
+#undef VECTOR2PRIMITIVES
+#undef STRINGS2PRIMITIVES
+#undef PRIMITIVES2NARROWS
+#undef BOOLS2NARROWS
+#undef FLOATS2INTS
+#undef ARRAY2ARRAY
+#undef NARROWS2ARRAY
+#undef MAP2ARRAY
+
+
+
+/***** Conversion Table *****/
+/* sxc_value_getv() and the normalize functions look up their conversions
+    here, by data type, rather than switching on it.  Identity conversions
+    are plain copies, done inline (see CONVERSION_COPY_*), the common pairs of
+    types have a function of their own (see PAIR_CONVERSIONS), and the rest
+    call the destination type's to_XXXX() function (which switches on the
+    source type).  Each row is checked at build time, so a data type can't be
+    left out or out of order. */
+
+/* NOTE dest_extra is the SxcXXXXBinding** or int* length some types take */
+typedef int ConvertFunc(SxcValue* value, void* dest, void* dest_extra);
+
+typedef struct _Conversion {
+  ConvertFunc* convert;
+  char extra;    /* what dest_extra is (see CONVERSION_EXTRA_*) */
+  char copy;     /* how a value of the same type is copied (see CONVERSION_COPY_*) */
+  char stype;    /* type sxc_value_snormalize() converts to (or sxc_null) */
+  char ctype;    /* type sxc_value_cnormalize() converts to (or sxc_null) */
+  char pair;     /* row and column in PAIR_CONVERSIONS (see CONVERSION_PAIR_*) */
+} Conversion;
+
+#define CONVERSION_EXTRA_NONE (0)
+#define CONVERSION_EXTRA_BINDING (1)
+#define CONVERSION_EXTRA_LENGTH (2)
+
+#define CONVERSION_COPY_NONE (0)
+#define CONVERSION_COPY_BOOL (1)
+#define CONVERSION_COPY_INT (2)
+#define CONVERSION_COPY_DOUBLE (3)
+#define CONVERSION_COPY_INT64 (4)
+#define CONVERSION_COPY_POINTER (5)
+#define CONVERSION_COPY_BINDING (6)
+#define CONVERSION_COPY_ARRAY (7)
+
+#define CONVERSION_PAIR_NONE (0)
+#define CONVERSION_PAIR_CBOOL (1)
+#define CONVERSION_PAIR_CINT (2)
+#define CONVERSION_PAIR_CDOUBLE (3)
+#define CONVERSION_PAIR_CINT64 (4)
+#define CONVERSION_PAIR_SSTRING (5)
+#define CONVERSION_PAIR_CSTRING (6)
+#define CONVERSION_PAIR_CCHARS (7)
+#define CONVERSION_PAIR_COUNT (8)
+
+
+static int convert_none(SxcValue* value, void* dest, void* dest_extra) {
+  (void)value;
+  (void)dest;
+  (void)dest_extra;
+  return SXC_FAILURE;
+}
+
+/***** macros to adapt to_XXXX() functions to ConvertFunc *****/
+#define CONVERT(TO, DEST_TYPE)                                            \
+  static int convert_##TO(SxcValue* value, void* dest, void* dest_extra) { \
+    (void)dest_extra;                                                     \
+    return to_##TO(value, (DEST_TYPE*)dest);                              \
+  }
+
+#define CONVERT_EXTRA(TO, DEST_TYPE, EXTRA_TYPE)                          \
+  static int convert_##TO(SxcValue* value, void* dest, void* dest_extra) { \
+    return to_##TO(value, (DEST_TYPE*)dest, (EXTRA_TYPE*)dest_extra);     \
+  }
+
+CONVERT(cbool, bool)
+CONVERT(cint, int)
+CONVERT(cdouble, double)
+CONVERT(cint64, SxcInt64)
+CONVERT(string, SxcString*)
+CONVERT(map, SxcMap*)
+CONVERT(func, SxcFunc*)
+CONVERT_EXTRA(sstring, void*, SxcStringBinding*)
+CONVERT_EXTRA(smap, void*, SxcMapBinding*)
+CONVERT_EXTRA(sfunc, void*, SxcFuncBinding*)
+CONVERT(cstring, char*)
+CONVERT(cpointer, void*)
+CONVERT(cfunc, SxcLibFunc*)
+CONVERT_EXTRA(cchars, char*, int)
+CONVERT_EXTRA(cbools, bool*, int)
+CONVERT_EXTRA(cints, int*, int)
+CONVERT_EXTRA(cdoubles, double*, int)
+CONVERT_EXTRA(cstrings, char**, int)
+CONVERT_EXTRA(cint64s, SxcInt64*, int)
+CONVERT_EXTRA(cfloats, float*, int)
+CONVERT_EXTRA(cint8s, signed char*, int)
+CONVERT_EXTRA(cuint8s, unsigned char*, int)
+CONVERT_EXTRA(cint16s, short*, int)
+CONVERT_EXTRA(cuint16s, unsigned short*, int)
+CONVERT_EXTRA(cstringrefs, SxcStringRef*, int)
+
+/***** macros be gone! *****/
+#undef CONVERT
+#undef CONVERT_EXTRA
+
+
+/* Conversions between numbers and booleans, and from script strings (which
+    is how scripts pass most args), are split out by source type, so they
+    don't switch on either type.  They must convert as the to_XXXX()
+    functions do. */
+
+/***** numbers and booleans ==> macro! *****/
+#define CONVERT_PAIR(FROM, TO, DEST_TYPE, EXPRESSION)                     \
+  static int convert_##FROM##_##TO(SxcValue* value, void* dest, void* dest_extra) { \
+    (void)dest_extra;                                                     \
+    *(DEST_TYPE*)dest = (EXPRESSION);                                     \
+    return SXC_SUCCESS;                                                   \
+  }
+
+CONVERT_PAIR(cint, cbool, bool, value->data.cint != 0)
+CONVERT_PAIR(cdouble, cbool, bool, value->data.cdouble != 0.0)
+CONVERT_PAIR(cint64, cbool, bool, value->data.cint64 != 0)
+CONVERT_PAIR(cbool, cint, int, value->data.cbool ? 1 : 0)
+CONVERT_PAIR(cdouble, cint, int, DOUBLE_TO_INT(value->data.cdouble))
+CONVERT_PAIR(cint64, cint, int, (int)SATURATE(value->data.cint64, INT_MIN, INT_MAX))
+CONVERT_PAIR(cbool, cdouble, double, value->data.cbool ? 1.0 : 0.0)
+CONVERT_PAIR(cint, cdouble, double, (double)(value->data.cint))
+CONVERT_PAIR(cint64, cdouble, double, (double)(value->data.cint64))
+CONVERT_PAIR(cbool, cint64, SxcInt64, value->data.cbool)
+CONVERT_PAIR(cint, cint64, SxcInt64, value->data.cint)
+CONVERT_PAIR(cdouble, cint64, SxcInt64, DOUBLE_TO_INT64(value->data.cdouble))
+
+/***** script strings to numbers ==> macro! *****/
+#define CONVERT_SSTRING_PAIR(TO, DEST_TYPE)                               \
+  static int convert_sstring_##TO(SxcValue* value, void* dest, void* dest_extra) { \
+    char* cchars;                                                         \
+    int length;                                                           \
+    (void)dest_extra;                                                     \
+    return sstring_to_cchars(value->context, value->data.sstring.underlying, \
+          value->data.sstring.binding, &cchars, &length)                  \
+      && cchars_to_##TO(cchars, length,                                   \
+          value->data.sstring.binding->is_null_terminated, (DEST_TYPE*)dest); \
+  }
+
+CONVERT_SSTRING_PAIR(cint, int)
+CONVERT_SSTRING_PAIR(cdouble, double)
+CONVERT_SSTRING_PAIR(cint64, SxcInt64)
+
+/***** macros be gone! *****/
+#undef CONVERT_PAIR
+#undef CONVERT_SSTRING_PAIR
+
+static int convert_sstring_cbool(SxcValue* value, void* dest, void* dest_extra) {
+  double cdouble;
+
+  if (!convert_sstring_cdouble(value, &cdouble, dest_extra)) {
+    return SXC_FAILURE;
+  }
+  *(bool*)dest = (cdouble != 0.0);
+  return SXC_SUCCESS;
+}
+
+static int convert_sstring_cstring(SxcValue* value, void* dest, void* dest_extra) {
+  char* cchars;
+  int length;
+
+  (void)dest_extra;
+  return sstring_to_cchars(value->context, value->data.sstring.underlying,
+          value->data.sstring.binding, &cchars, &length)
+    && cchars_to_cstring(value->context, cchars, length,
+          value->data.sstring.binding->is_null_terminated, (char**)dest);
+}
+
+static int convert_sstring_cchars(SxcValue* value, void* dest, void* dest_extra) {
+  return sstring_to_cchars(value->context, value->data.sstring.underlying,
+          value->data.sstring.binding, (char**)dest, (int*)dest_extra);
+}
+
+
+/* [source pair][destination pair] (see Conversion.pair); NULL falls back to
+    the destination type's converter, as do identity pairs, which are copied
+    before getting here */
+static ConvertFunc* const PAIR_CONVERSIONS[CONVERSION_PAIR_COUNT][CONVERSION_PAIR_COUNT] = {
+  /* NONE */    {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL},
+  /* CBOOL */   {NULL, NULL, convert_cbool_cint, convert_cbool_cdouble, convert_cbool_cint64, NULL, NULL, NULL},
+  /* CINT */    {NULL, convert_cint_cbool, NULL, convert_cint_cdouble, convert_cint_cint64, NULL, NULL, NULL},
+  /* CDOUBLE */ {NULL, convert_cdouble_cbool, convert_cdouble_cint, NULL, convert_cdouble_cint64, NULL, NULL, NULL},
+  /* CINT64 */  {NULL, convert_cint64_cbool, convert_cint64_cint, convert_cint64_cdouble, NULL, NULL, NULL, NULL},
+  /* SSTRING */ {NULL, convert_sstring_cbool, convert_sstring_cint, convert_sstring_cdouble,
+                 convert_sstring_cint64, NULL, convert_sstring_cstring, convert_sstring_cchars},
+  /* CSTRING */ {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL},
+  /* CCHARS */  {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL}
+};
+
+
+/* (type, convert, extra, copy, stype, ctype, pair), in SxcDataType order */
+#define CONVERSION_ROWS(ROW)                                              \
+  ROW(sxc_null, convert_none, NONE, NONE, sxc_null, sxc_null, NONE)       \
+  ROW(sxc_cbool, convert_cbool, NONE, BOOL, sxc_null, sxc_null, CBOOL)    \
+  ROW(sxc_cint, convert_cint, NONE, INT, sxc_null, sxc_null, CINT)        \
+  ROW(sxc_cdouble, convert_cdouble, NONE, DOUBLE, sxc_null, sxc_null, CDOUBLE) \
+  ROW(sxc_string, convert_string, NONE, POINTER, sxc_sstring, sxc_null, NONE) \
+  ROW(sxc_map, convert_map, NONE, POINTER, sxc_smap, sxc_null, NONE)      \
+  ROW(sxc_func, convert_func, NONE, POINTER, sxc_sfunc, sxc_null, NONE)   \
+  ROW(sxc_sstring, convert_sstring, BINDING, BINDING, sxc_null, sxc_string, SSTRING) \
+  ROW(sxc_smap, convert_smap, BINDING, BINDING, sxc_null, sxc_map, NONE)  \
+  ROW(sxc_sfunc, convert_sfunc, BINDING, BINDING, sxc_null, sxc_func, NONE) \
+  ROW(sxc_cstring, convert_cstring, NONE, POINTER, sxc_sstring, sxc_null, CSTRING) \
+  ROW(sxc_cpointer, convert_cpointer, NONE, POINTER, sxc_sstring, sxc_null, NONE) \
+  ROW(sxc_cfunc, convert_cfunc, NONE, POINTER, sxc_sfunc, sxc_null, NONE) \
+  ROW(sxc_cchars, convert_cchars, LENGTH, ARRAY, sxc_sstring, sxc_null, CCHARS) \
+  ROW(sxc_cbools, convert_cbools, LENGTH, ARRAY, sxc_smap, sxc_null, NONE) \
+  ROW(sxc_cints, convert_cints, LENGTH, ARRAY, sxc_smap, sxc_null, NONE)  \
+  ROW(sxc_cdoubles, convert_cdoubles, LENGTH, ARRAY, sxc_smap, sxc_null, NONE) \
+  ROW(sxc_cstrings, convert_cstrings, LENGTH, ARRAY, sxc_smap, sxc_null, NONE) \
+  ROW(sxc_cint64, convert_cint64, NONE, INT64, sxc_null, sxc_null, CINT64) \
+  ROW(sxc_cint64s, convert_cint64s, LENGTH, ARRAY, sxc_smap, sxc_null, NONE) \
+  ROW(sxc_cfloats, convert_cfloats, LENGTH, ARRAY, sxc_smap, sxc_null, NONE) \
+  ROW(sxc_cint8s, convert_cint8s, LENGTH, ARRAY, sxc_smap, sxc_null, NONE) \
+  ROW(sxc_cuint8s, convert_cuint8s, LENGTH, ARRAY, sxc_smap, sxc_null, NONE) \
+  ROW(sxc_cint16s, convert_cint16s, LENGTH, ARRAY, sxc_smap, sxc_null, NONE) \
+  ROW(sxc_cuint16s, convert_cuint16s, LENGTH, ARRAY, sxc_smap, sxc_null, NONE) \
+  ROW(sxc_cstringrefs, convert_cstringrefs, LENGTH, ARRAY, sxc_smap, sxc_null, NONE)
+
+#define CONVERSION_ROW(TYPE, CONVERT, EXTRA, COPY, STYPE, CTYPE, PAIR)    \
+  {CONVERT, CONVERSION_EXTRA_##EXTRA, CONVERSION_COPY_##COPY, STYPE, CTYPE, \
+    CONVERSION_PAIR_##PAIR},
+
+static const Conversion CONVERSIONS[] = {
+  CONVERSION_ROWS(CONVERSION_ROW)
+};
+
+/* build time checks: one row per data type, each at its type's index */
+#define CONVERSION_ROW_INDEX(TYPE, CONVERT, EXTRA, COPY, STYPE, CTYPE, PAIR) TYPE##_row,
+#define CONVERSION_ROW_CHECK(TYPE, CONVERT, EXTRA, COPY, STYPE, CTYPE, PAIR) \
+  typedef char TYPE##_row_is_in_order[((int)TYPE##_row == (int)TYPE) ? 1 : -1];
+
+enum { CONVERSION_ROWS(CONVERSION_ROW_INDEX) conversion_row_count };
+CONVERSION_ROWS(CONVERSION_ROW_CHECK)
+typedef char every_type_has_a_row[((int)conversion_row_count == (int)_sxc_datatype_count) ? 1 : -1];
+
+/***** macros be gone! *****/
+#undef CONVERSION_ROWS
+#undef CONVERSION_ROW
+#undef CONVERSION_ROW_INDEX
+#undef CONVERSION_ROW_CHECK
+
+#define IS_DATA_TYPE(TYPE) ((TYPE) >= 0 && (TYPE) < _sxc_datatype_count)
+
+
+
+/***** SxcValue Functions *****/
+
+int sxc_value_getv(SxcValue* value, SxcDataType type, va_list varg) {
+  const Conversion* conversion;
+  ConvertFunc* pair;
+  /* these variables are necessary because evaluation of function arguments in C
+      is not well-defined (god knows why), thus the va_arg macro gets confused
+      when used as a to_XXXX() arg */
+  void* dest = NULL;
+  void* dest_extra = NULL;
+
+  if (!IS_DATA_TYPE(type)) {
+    if (type == sxc_value) {
+      *(va_arg(varg, SxcValue*)) = *value;
+      return SXC_SUCCESS;
+    } else {
+      return SXC_FAILURE;
+    }
   }
+
+  conversion = &CONVERSIONS[type];
+  if (type != sxc_null) {
+    dest = va_arg(varg, void*);
+  }
+  if (conversion->extra != CONVERSION_EXTRA_NONE) {
+    dest_extra = va_arg(varg, void*);
+  }
+
+  if (value->type == type) {
+    switch (conversion->copy) {
+      case CONVERSION_COPY_BOOL:
+        *(bool*)dest = value->data.cbool;
+        return SXC_SUCCESS;
+      case CONVERSION_COPY_INT:
+        *(int*)dest = value->data.cint;
+        return SXC_SUCCESS;
+      case CONVERSION_COPY_DOUBLE:
+        *(double*)dest = value->data.cdouble;
+        return SXC_SUCCESS;
+      case CONVERSION_COPY_INT64:
+        *(SxcInt64*)dest = value->data.cint64;
+        return SXC_SUCCESS;
+      case CONVERSION_COPY_POINTER:
+        *(void**)dest = value->data._pointer_store;
+        return SXC_SUCCESS;
+      case CONVERSION_COPY_BINDING:
+        *(void**)dest = value->data._binding_store.underlying;
+        *(void**)dest_extra = value->data._binding_store.binding;
+        return SXC_SUCCESS;
+      case CONVERSION_COPY_ARRAY:
+        *(void**)dest = value->data._array_store.array;
+        *(int*)dest_extra = value->data._array_store.length;
+        return SXC_SUCCESS;
+      default:
+        break;
+    }
+  }
+
+  pair = IS_DATA_TYPE(value->type)
+      ? PAIR_CONVERSIONS[(int)CONVERSIONS[value->type].pair][(int)conversion->pair] : NULL;
+  return (pair != NULL ? pair : conversion->convert)(value, dest, dest_extra);
 }
 
 
@@ -941,12 +2133,16 @@ void sxc_value_setv(SxcValue* value, SxcDataType type, va_list varg) {
       case sxc_cbool:
         /* NOTE char var args are always promoted to int (see http://c-faq.com/varargs/float.html) */
         value->data.cbool = (char)va_arg(varg, int); /* TODO? coerce to 0 or 1 */
+        break;
       case sxc_cint:
         value->data.cint = va_arg(varg, int);
         break;
       case sxc_cdouble:
         value->data.cdouble = va_arg(varg, double);
         break;
+      case sxc_cint64:
+        value->data.cint64 = va_arg(varg, SxcInt64);
+        break;
 
       case sxc_string:
       case sxc_map:
@@ -972,6 +2168,13 @@ void sxc_value_setv(SxcValue* value, SxcDataType type, va_list varg) {
       case sxc_cints:
       case sxc_cdoubles:
       case sxc_cstrings:
+      case sxc_cint64s:
+      case sxc_cfloats:
+      case sxc_cint8s:
+      case sxc_cuint8s:
+      case sxc_cint16s:
+      case sxc_cuint16s:
+      case sxc_cstringrefs:
         value->data._array_store.array = va_arg(varg, void*);
         value->data._array_store.length = va_arg(varg, int);
         break;
@@ -999,66 +2202,126 @@ void sxc_value_set(SxcValue* value, SxcDataType type, SXC_DATA_ARG) {
 
 
 void sxc_value_snormalize(SxcValue* value) {
+  SxcDataType stype = IS_DATA_TYPE(value->type) ? CONVERSIONS[value->type].stype : sxc_null;
   SxcData data;
 
-  switch (value->type) {
-    case sxc_string:
-    case sxc_cstring:
-    case sxc_cpointer:
-    case sxc_cchars:
-      to_sstring(value, &data.sstring.underlying, &data.sstring.binding);
-      value->type = sxc_sstring;
-      value->data = data;
-      break;
-
-    case sxc_map:
-    case sxc_cbools:
-    case sxc_cints:
-    case sxc_cdoubles:
-    case sxc_cstrings:
-      to_smap(value, &data.smap.underlying, &data.smap.binding);
-      value->type = sxc_smap;
+  /* NOTE sxc_null means already interned */
+  if (stype != sxc_null) {
+    /* NOTE conversions only fail when allocation fails in nothrow mode, with
+        the error set in value->context */
+    if ((CONVERSIONS[stype].convert)(value, &data._binding_store.underlying, &data._binding_store.binding)) {
+      value->type = stype;
       value->data = data;
-      break;
-
-    case sxc_func:
-    case sxc_cfunc:
-      to_sfunc(value, &data.sfunc.underlying, &data.sfunc.binding);
-      value->type = sxc_sfunc;
-      value->data = data;
-      break;
-
-    default:
-      /* already interned */
-      break;
+    } else {
+      value->type = sxc_null;
+    }
   }
 }
 
 /* NOTE not the best name for this function, but it mirrors sxc_value_intern() */
 void sxc_value_cnormalize(SxcValue* value) {
+  SxcDataType ctype = IS_DATA_TYPE(value->type) ? CONVERSIONS[value->type].ctype : sxc_null;
   SxcData data;
 
-  switch (value->type) {
-    case sxc_sstring:
-      to_string(value, &(data.string));
-      value->type = sxc_string;
-      value->data.string = data.string;
-      break;
-
-    case sxc_smap:
-      to_map(value, &(data.map));
-      value->type = sxc_map;
-      value->data.map = data.map;
-      break;
-
-    case sxc_sfunc:
-      to_func(value, &(data.func));
-      value->type = sxc_func;
-      value->data.func = data.func;
-      break;
-
-    default:
-      /* already "externed" */
-      break;
+  /* NOTE sxc_null means already "externed" */
+  if (ctype != sxc_null) {
+    if ((CONVERSIONS[ctype].convert)(value, &data._pointer_store, NULL)) {
+      value->type = ctype;
+      value->data._pointer_store = data._pointer_store;
+    } else {
+      value->type = sxc_null;
+    }
   }
 }
+
+
+
+/***** SxcBuffer Functions *****/
+
+/* returns the size of an element of the given buffer type, or 0 if buffers
+    can't be of that type */
+int sxc_value_elementsize(SxcDataType type) {
+  switch (type) {
+    case sxc_cbools: return sizeof(bool);
+    case sxc_cints: return sizeof(int);
+    case sxc_cdoubles: return sizeof(double);
+    case sxc_cint64s: return sizeof(int64);
+    case sxc_cfloats: return sizeof(float);
+    case sxc_cint8s: return sizeof(int8);
+    case sxc_cuint8s: return sizeof(uint8);
+    case sxc_cint16s: return sizeof(int16);
+    case sxc_cuint16s: return sizeof(uint16);
+    default: return 0;
+  }
+}
+
+
+/* NOTE elements are seen as primitives, the same way as when a buffer's type
+    of array is converted to a script map */
+int sxc_buffer_get(SxcBuffer* buffer, int index, SxcValue* return_value) {
+  if (index < 0 || index >= buffer->length) {
+    sxc_value_set(return_value, sxc_null);
+    return SXC_FAILURE;
+  }
+
+  switch (buffer->type) {
+    case sxc_cbools:
+      sxc_value_set(return_value, sxc_cbool, ((bool*)buffer->array)[index]);
+      return SXC_SUCCESS;
+    case sxc_cints:
+      sxc_value_set(return_value, sxc_cint, ((int*)buffer->array)[index]);
+      return SXC_SUCCESS;
+    case sxc_cdoubles:
+      sxc_value_set(return_value, sxc_cdouble, ((double*)buffer->array)[index]);
+      return SXC_SUCCESS;
+    case sxc_cint64s:
+      sxc_value_set(return_value, sxc_cint64, ((int64*)buffer->array)[index]);
+      return SXC_SUCCESS;
+    case sxc_cfloats:
+      sxc_value_set(return_value, sxc_cdouble, (double)((float*)buffer->array)[index]);
+      return SXC_SUCCESS;
+    case sxc_cint8s:
+      sxc_value_set(return_value, sxc_cint, (int)((int8*)buffer->array)[index]);
+      return SXC_SUCCESS;
+    case sxc_cuint8s:
+      sxc_value_set(return_value, sxc_cint, (int)((uint8*)buffer->array)[index]);
+      return SXC_SUCCESS;
+    case sxc_cint16s:
+      sxc_value_set(return_value, sxc_cint, (int)((int16*)buffer->array)[index]);
+      return SXC_SUCCESS;
+    case sxc_cuint16s:
+      sxc_value_set(return_value, sxc_cint, (int)((uint16*)buffer->array)[index]);
+      return SXC_SUCCESS;
+    default:
+      sxc_value_set(return_value, sxc_null);
+      return SXC_FAILURE;
+  }
+}
+
+
+/* sets element, of the given array type's element type, to value (converted
+    and clamped as elements of that type of array are) */
+int sxc_value_toelement(SxcValue* value, SxcDataType type, void* element) {
+  switch (type) {
+    case sxc_cbools: return to_cbool(value, (bool*)element);
+    case sxc_cints: return to_cint(value, (int*)element);
+    case sxc_cdoubles: return to_cdouble(value, (double*)element);
+    case sxc_cint64s: return to_cint64(value, (int64*)element);
+    case sxc_cfloats: return to_cfloat(value, (float*)element);
+    case sxc_cint8s: return to_cint8(value, (int8*)element);
+    case sxc_cuint8s: return to_cuint8(value, (uint8*)element);
+    case sxc_cint16s: return to_cint16(value, (int16*)element);
+    case sxc_cuint16s: return to_cuint16(value, (uint16*)element);
+    default: return SXC_FAILURE;
+  }
+}
+
+
+/* NOTE buffers never grow */
+int sxc_buffer_set(SxcBuffer* buffer, int index, SxcValue* value) {
+  if (index < 0 || index >= buffer->length) {
+    return SXC_FAILURE;
+  }
+  return sxc_value_toelement(value, buffer->type,
+      (char*)buffer->array + index * sxc_value_elementsize(buffer->type));
+}
@@ -0,0 +1,392 @@
+#include <limits.h>
+#include "sxc.h"
+
+
+/***** Array Conversion Kernels *****/
+/* Converting the primitive array types to one another one element at a time
+    leaves most of the CPU idle, and these arrays can hold millions of
+    elements.  On x86 the bulk of each array is converted with SSE2 (always
+    available on x86-64) and, if the CPU supports it (checked once, at
+    runtime), AVX2; the elements left over, and whole arrays elsewhere, are
+    converted by the scalar loops.
+
+    Every path gives the same results:
+      - to bool: nonzero (including NaN) is true (1)
+      - from bool: true (any nonzero char) is 1
+      - double to int: truncated toward zero and clamped to
+          [INT_MIN, INT_MAX] (NaN becomes 0) */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define HAS_SSE2 (1)
+  #include <emmintrin.h>
+#else
+  #define HAS_SSE2 (0)
+#endif
+
+/* NOTE only the avx2_*() functions are compiled for AVX2, so the library
+    still runs on x86 CPUs without it */
+#if HAS_SSE2 && (defined(__clang__) \
+    || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+  #define HAS_AVX2 (1)
+  #define TARGET_AVX2 __attribute__((target("avx2")))
+  #include <immintrin.h>
+#else
+  #define HAS_AVX2 (0)
+#endif
+
+/* each kernel converts as many whole blocks of elements as it can, and
+    returns how many elements that was */
+#if HAS_AVX2
+  #define RUN_AVX2(KERNEL, SRC, DEST, LENGTH) \
+    (has_avx2() ? avx2_##KERNEL((SRC), (DEST), (LENGTH)) : 0)
+#else
+  #define RUN_AVX2(KERNEL, SRC, DEST, LENGTH) (0)
+#endif
+
+#if HAS_SSE2
+  #define RUN_SSE2(KERNEL, SRC, DEST, LENGTH) sse2_##KERNEL((SRC), (DEST), (LENGTH))
+#else
+  #define RUN_SSE2(KERNEL, SRC, DEST, LENGTH) (0)
+#endif
+
+/* see DOUBLE_TO_INT in sxc_value.c */
+#define TO_INT(X) \
+  ((X) >= (double)INT_MAX + 1.0 ? INT_MAX : (X) > (double)INT_MIN - 1.0 ? (int)(X) \
+    : (X) <= (double)INT_MIN - 1.0 ? INT_MIN : 0)
+
+
+
+/***** CPU Detection *****/
+
+#if HAS_AVX2
+/* 0 until checked, then 1 without AVX2 or 2 with it
+    NOTE threads racing to check will all store the same value */
+static int avx2_support = 0;
+
+static int has_avx2(void) {
+  if (avx2_support == 0) {
+    __builtin_cpu_init();
+    avx2_support = __builtin_cpu_supports("avx2") ? 2 : 1;
+  }
+  return (avx2_support == 2);
+}
+#endif
+
+
+
+/***** SSE2 Kernels *****/
+
+#if HAS_SSE2
+/* packs 16 int masks (all bits set or clear) into 16 bools */
+static __m128i sse2_masks_to_bools(__m128i a, __m128i b, __m128i c, __m128i d) {
+  return _mm_and_si128(_mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)),
+      _mm_set1_epi8(1));
+}
+
+
+/* packs 4 double masks into 4 int masks */
+static __m128i sse2_double_masks(__m128d a, __m128d b) {
+  return _mm_castps_si128(_mm_shuffle_ps(_mm_castpd_ps(a), _mm_castpd_ps(b),
+      _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+
+static int sse2_intstobools(const int* src, bool* dest, int length) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i a, b, c, d;
+  int i;
+
+  for (i = 0; i + 16 <= length; i += 16) {
+    a = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(src + i)), zero);
+    b = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(src + i + 4)), zero);
+    c = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(src + i + 8)), zero);
+    d = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(src + i + 12)), zero);
+    _mm_storeu_si128((__m128i*)(dest + i), _mm_xor_si128(sse2_masks_to_bools(a, b, c, d),
+        _mm_set1_epi8(1)));
+  }
+  return i;
+}
+
+
+static int sse2_doublestobools(const double* src, bool* dest, int length) {
+  const __m128d zero = _mm_setzero_pd();
+  __m128i masks[4];
+  int i, j;
+
+  for (i = 0; i + 16 <= length; i += 16) {
+    for (j = 0; j < 4; j += 1) {
+      /* NOTE NaN != 0 */
+      masks[j] = sse2_double_masks(_mm_cmpneq_pd(_mm_loadu_pd(src + i + j * 4), zero),
+          _mm_cmpneq_pd(_mm_loadu_pd(src + i + j * 4 + 2), zero));
+    }
+    _mm_storeu_si128((__m128i*)(dest + i),
+        sse2_masks_to_bools(masks[0], masks[1], masks[2], masks[3]));
+  }
+  return i;
+}
+
+
+static int sse2_boolstoints(const bool* src, int* dest, int length) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i x, half;
+  int i;
+
+  for (i = 0; i + 16 <= length; i += 16) {
+    x = _mm_min_epu8(_mm_loadu_si128((const __m128i*)(src + i)), _mm_set1_epi8(1));
+    half = _mm_unpacklo_epi8(x, zero);
+    _mm_storeu_si128((__m128i*)(dest + i), _mm_unpacklo_epi16(half, zero));
+    _mm_storeu_si128((__m128i*)(dest + i + 4), _mm_unpackhi_epi16(half, zero));
+    half = _mm_unpackhi_epi8(x, zero);
+    _mm_storeu_si128((__m128i*)(dest + i + 8), _mm_unpacklo_epi16(half, zero));
+    _mm_storeu_si128((__m128i*)(dest + i + 12), _mm_unpackhi_epi16(half, zero));
+  }
+  return i;
+}
+
+
+static int sse2_boolstodoubles(const bool* src, double* dest, int length) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i x, half, ints;
+  int i, j;
+
+  for (i = 0; i + 16 <= length; i += 16) {
+    x = _mm_min_epu8(_mm_loadu_si128((const __m128i*)(src + i)), _mm_set1_epi8(1));
+    for (j = 0; j < 4; j += 1) {
+      half = (j < 2) ? _mm_unpacklo_epi8(x, zero) : _mm_unpackhi_epi8(x, zero);
+      ints = (j % 2 == 0) ? _mm_unpacklo_epi16(half, zero) : _mm_unpackhi_epi16(half, zero);
+      _mm_storeu_pd(dest + i + j * 4, _mm_cvtepi32_pd(ints));
+      _mm_storeu_pd(dest + i + j * 4 + 2,
+          _mm_cvtepi32_pd(_mm_shuffle_epi32(ints, _MM_SHUFFLE(3, 2, 3, 2))));
+    }
+  }
+  return i;
+}
+
+
+static int sse2_intstodoubles(const int* src, double* dest, int length) {
+  __m128i x;
+  int i;
+
+  for (i = 0; i + 4 <= length; i += 4) {
+    x = _mm_loadu_si128((const __m128i*)(src + i));
+    _mm_storeu_pd(dest + i, _mm_cvtepi32_pd(x));
+    _mm_storeu_pd(dest + i + 2, _mm_cvtepi32_pd(_mm_shuffle_epi32(x, _MM_SHUFFLE(3, 2, 3, 2))));
+  }
+  return i;
+}
+
+
+/* NOTE cvttpd gives INT_MIN for NaN and out of range doubles, so NaNs are
+    zeroed and the rest clamped first */
+static __m128i sse2_doubles_to_ints(__m128d x) {
+  x = _mm_and_pd(x, _mm_cmpord_pd(x, x));
+  x = _mm_min_pd(_mm_max_pd(x, _mm_set1_pd((double)INT_MIN)), _mm_set1_pd((double)INT_MAX));
+  return _mm_cvttpd_epi32(x);
+}
+
+
+static int sse2_doublestoints(const double* src, int* dest, int length) {
+  int i;
+
+  for (i = 0; i + 4 <= length; i += 4) {
+    _mm_storeu_si128((__m128i*)(dest + i),
+        _mm_unpacklo_epi64(sse2_doubles_to_ints(_mm_loadu_pd(src + i)),
+            sse2_doubles_to_ints(_mm_loadu_pd(src + i + 2))));
+  }
+  return i;
+}
+#endif
+
+
+
+/***** AVX2 Kernels *****/
+
+#if HAS_AVX2
+/* packs 32 int masks (all bits set or clear) into 32 bools
+    NOTE AVX2 packs within each 128-bit lane, so the result is reordered */
+TARGET_AVX2
+static __m256i avx2_masks_to_bools(__m256i a, __m256i b, __m256i c, __m256i d) {
+  __m256i bools = _mm256_packs_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+
+  bools = _mm256_permutevar8x32_epi32(bools, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+  return _mm256_and_si256(bools, _mm256_set1_epi8(1));
+}
+
+
+/* packs 8 double masks into 8 int masks */
+TARGET_AVX2
+static __m256i avx2_double_masks(__m256d a, __m256d b) {
+  __m256i masks = _mm256_castps_si256(_mm256_shuffle_ps(_mm256_castpd_ps(a),
+      _mm256_castpd_ps(b), _MM_SHUFFLE(2, 0, 2, 0)));
+
+  return _mm256_permutevar8x32_epi32(masks, _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7));
+}
+
+
+TARGET_AVX2
+static int avx2_intstobools(const int* src, bool* dest, int length) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i a, b, c, d;
+  int i;
+
+  for (i = 0; i + 32 <= length; i += 32) {
+    a = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(src + i)), zero);
+    b = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(src + i + 8)), zero);
+    c = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(src + i + 16)), zero);
+    d = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(src + i + 24)), zero);
+    _mm256_storeu_si256((__m256i*)(dest + i), _mm256_xor_si256(avx2_masks_to_bools(a, b, c, d),
+        _mm256_set1_epi8(1)));
+  }
+  return i;
+}
+
+
+TARGET_AVX2
+static int avx2_doublestobools(const double* src, bool* dest, int length) {
+  const __m256d zero = _mm256_setzero_pd();
+  __m256i masks[4];
+  int i, j;
+
+  for (i = 0; i + 32 <= length; i += 32) {
+    for (j = 0; j < 4; j += 1) {
+      /* NOTE NaN != 0 (unordered compare) */
+      masks[j] = avx2_double_masks(
+          _mm256_cmp_pd(_mm256_loadu_pd(src + i + j * 8), zero, _CMP_NEQ_UQ),
+          _mm256_cmp_pd(_mm256_loadu_pd(src + i + j * 8 + 4), zero, _CMP_NEQ_UQ));
+    }
+    _mm256_storeu_si256((__m256i*)(dest + i),
+        avx2_masks_to_bools(masks[0], masks[1], masks[2], masks[3]));
+  }
+  return i;
+}
+
+
+TARGET_AVX2
+static int avx2_boolstoints(const bool* src, int* dest, int length) {
+  __m128i x;
+  int i;
+
+  for (i = 0; i + 16 <= length; i += 16) {
+    x = _mm_min_epu8(_mm_loadu_si128((const __m128i*)(src + i)), _mm_set1_epi8(1));
+    _mm256_storeu_si256((__m256i*)(dest + i), _mm256_cvtepu8_epi32(x));
+    _mm256_storeu_si256((__m256i*)(dest + i + 8), _mm256_cvtepu8_epi32(_mm_srli_si128(x, 8)));
+  }
+  return i;
+}
+
+
+TARGET_AVX2
+static int avx2_boolstodoubles(const bool* src, double* dest, int length) {
+  __m128i x;
+  __m256i ints;
+  int i;
+
+  for (i = 0; i + 8 <= length; i += 8) {
+    x = _mm_min_epu8(_mm_loadl_epi64((const __m128i*)(src + i)), _mm_set1_epi8(1));
+    ints = _mm256_cvtepu8_epi32(x);
+    _mm256_storeu_pd(dest + i, _mm256_cvtepi32_pd(_mm256_castsi256_si128(ints)));
+    _mm256_storeu_pd(dest + i + 4, _mm256_cvtepi32_pd(_mm256_extracti128_si256(ints, 1)));
+  }
+  return i;
+}
+
+
+TARGET_AVX2
+static int avx2_intstodoubles(const int* src, double* dest, int length) {
+  __m256i x;
+  int i;
+
+  for (i = 0; i + 8 <= length; i += 8) {
+    x = _mm256_loadu_si256((const __m256i*)(src + i));
+    _mm256_storeu_pd(dest + i, _mm256_cvtepi32_pd(_mm256_castsi256_si128(x)));
+    _mm256_storeu_pd(dest + i + 4, _mm256_cvtepi32_pd(_mm256_extracti128_si256(x, 1)));
+  }
+  return i;
+}
+
+
+/* see sse2_doubles_to_ints() */
+TARGET_AVX2
+static __m128i avx2_doubles_to_ints(__m256d x) {
+  x = _mm256_and_pd(x, _mm256_cmp_pd(x, x, _CMP_ORD_Q));
+  x = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd((double)INT_MIN)),
+      _mm256_set1_pd((double)INT_MAX));
+  return _mm256_cvttpd_epi32(x);
+}
+
+
+TARGET_AVX2
+static int avx2_doublestoints(const double* src, int* dest, int length) {
+  int i;
+
+  for (i = 0; i + 8 <= length; i += 8) {
+    _mm256_storeu_si256((__m256i*)(dest + i),
+        _mm256_inserti128_si256(_mm256_castsi128_si256(avx2_doubles_to_ints(_mm256_loadu_pd(src + i))),
+            avx2_doubles_to_ints(_mm256_loadu_pd(src + i + 4)), 1));
+  }
+  return i;
+}
+#endif
+
+
+
+/***** Array Conversion Functions *****/
+
+void sxc_vector_intstobools(const int* src, bool* dest, int length) {
+  int i = RUN_AVX2(intstobools, src, dest, length);
+
+  i += RUN_SSE2(intstobools, src + i, dest + i, length - i);
+  for (; i < length; i += 1) {
+    dest[i] = (src[i] != 0);
+  }
+}
+
+
+void sxc_vector_doublestobools(const double* src, bool* dest, int length) {
+  int i = RUN_AVX2(doublestobools, src, dest, length);
+
+  i += RUN_SSE2(doublestobools, src + i, dest + i, length - i);
+  for (; i < length; i += 1) {
+    dest[i] = (src[i] != 0.0);
+  }
+}
+
+
+void sxc_vector_boolstoints(const bool* src, int* dest, int length) {
+  int i = RUN_AVX2(boolstoints, src, dest, length);
+
+  i += RUN_SSE2(boolstoints, src + i, dest + i, length - i);
+  for (; i < length; i += 1) {
+    dest[i] = src[i] ? 1 : 0;
+  }
+}
+
+
+void sxc_vector_boolstodoubles(const bool* src, double* dest, int length) {
+  int i = RUN_AVX2(boolstodoubles, src, dest, length);
+
+  i += RUN_SSE2(boolstodoubles, src + i, dest + i, length - i);
+  for (; i < length; i += 1) {
+    dest[i] = src[i] ? 1.0 : 0.0;
+  }
+}
+
+
+void sxc_vector_intstodoubles(const int* src, double* dest, int length) {
+  int i = RUN_AVX2(intstodoubles, src, dest, length);
+
+  i += RUN_SSE2(intstodoubles, src + i, dest + i, length - i);
+  for (; i < length; i += 1) {
+    dest[i] = (double)src[i];
+  }
+}
+
+
+void sxc_vector_doublestoints(const double* src, int* dest, int length) {
+  int i = RUN_AVX2(doublestoints, src, dest, length);
+
+  i += RUN_SSE2(doublestoints, src + i, dest + i, length - i);
+  for (; i < length; i += 1) {
+    dest[i] = TO_INT(src[i]);
+  }
+}